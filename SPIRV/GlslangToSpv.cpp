@@ -1054,7 +1054,7 @@ void TGlslangToSpvTraverser::visitSymbol(glslang::TIntermSymbol* symbol)
     }
 
     // Only process non-linkage-only nodes for generating actual static uses
-    if (! linkageOnly || symbol->getQualifier().isSpecConstant()) {
+    if (! linkageOnly || symbol->getType().getQualifier().isSpecConstant()) {
         // Prepare to generate code for the access
 
         // L-value chains will be computed left to right.  We're on the symbol now,
@@ -1068,7 +1068,7 @@ void TGlslangToSpvTraverser::visitSymbol(glslang::TIntermSymbol* symbol)
         //    See comments in handleUserFunctionCall().
         // B) Specialization constants (normal constants don't even come in as a variable),
         //    These are also pure R-values.
-        glslang::TQualifier qualifier = symbol->getQualifier();
+        glslang::TQualifier qualifier = symbol->getType().getQualifier();
         if (qualifier.isSpecConstant() || rValueParameters.find(symbol->getId()) != rValueParameters.end())
             builder.setAccessChainRValue(id);
         else
@@ -2432,7 +2432,7 @@ spv::Id TGlslangToSpvTraverser::convertGlslangStructToSpvType(const glslang::TTy
     std::vector<spv::Id> spvMembers;
     int memberDelta = 0;  // how much the member's index changes from glslang to SPIR-V, normally 0, except sometimes for blocks
     for (int i = 0; i < (int)glslangMembers->size(); i++) {
-        glslang::TType& glslangMember = *(*glslangMembers)[i].type;
+        const glslang::TType& glslangMember = *(*glslangMembers)[i].type;
         if (glslangMember.hiddenMember()) {
             ++memberDelta;
             if (type.getBasicType() == glslang::EbtBlock)
@@ -2477,7 +2477,7 @@ void TGlslangToSpvTraverser::decorateStructType(const glslang::TType& type,
     int offset = -1;
     int locationOffset = 0;  // for use within the members of this struct
     for (int i = 0; i < (int)glslangMembers->size(); i++) {
-        glslang::TType& glslangMember = *(*glslangMembers)[i].type;
+        const glslang::TType& glslangMember = *(*glslangMembers)[i].type;
         int member = i;
         if (type.getBasicType() == glslang::EbtBlock) {
             member = memberRemapper[glslangMembers][i];
@@ -2850,7 +2850,8 @@ void TGlslangToSpvTraverser::updateMemberOffset(const glslang::TType& /*structTy
 
 void TGlslangToSpvTraverser::declareUseOfStructMember(const glslang::TTypeList& members, int glslangMember)
 {
-    const glslang::TBuiltInVariable glslangBuiltIn = members[glslangMember].type->getQualifier().builtIn;
+    const glslang::TType& memberType = *members[glslangMember].type;
+    const glslang::TBuiltInVariable glslangBuiltIn = memberType.getQualifier().builtIn;
     switch (glslangBuiltIn)
     {
     case glslang::EbvClipDistance:
@@ -5806,6 +5807,9 @@ void GlslangToSpv(const glslang::TIntermediate& intermediate, std::vector<unsign
     if (options == nullptr)
         options = &defaultOptions;
 
+    // What is allocated here is popped below, so the tree's types are only
+    // read through const ones: reading a qualifier through a non-const type
+    // copies it into the pool first (see TType).
     glslang::GetThreadPoolAllocator().push();
 
     TGlslangToSpvTraverser it(&intermediate, logger, *options);
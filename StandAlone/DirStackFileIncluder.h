@@ -40,6 +40,18 @@
 #include <string>
 #include <fstream>
 #include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include "./../glslang/Public/ShaderLang.h"
 
@@ -139,3 +151,238 @@ protected:
         return last == std::string::npos ? "." : path.substr(0, last);
     }
 };
+
+// The contents of files read for #include, kept for the next time they are
+// included, by any number of includers on any number of threads.  Files of
+// MinMappedLength bytes or more are memory mapped where that's supported, so
+// they must not be truncated while in the cache: reading a page past the new
+// end raises SIGBUS.  Replacing them, as editors and build tools do, is fine.
+// Each use checks the file's size, modification time, and inode, reading it
+// again if changed.  Beyond the number of files or bytes of contents it was
+// made to hold, the least recently used are dropped.
+class IncludeFileCache {
+public:
+    // One file's contents, as of when it was read.
+    class File {
+    public:
+        File() : data(nullptr), length(0), mapped(false), size(0), modified(0), inode(0) { }
+        ~File()
+        {
+#ifndef _WIN32
+            if (mapped) {
+                munmap(const_cast<char*>(data), length);
+                return;
+            }
+#endif
+            delete [] data;
+        }
+
+        const char* getData() const { return data; }
+        size_t getLength() const { return length; }
+
+        bool isCurrent(const struct stat& status) const
+        {
+            return status.st_size == size && status.st_mtime == modified && status.st_ino == inode;
+        }
+
+    private:
+        File(const File&);
+        File& operator=(const File&);
+
+        friend class IncludeFileCache;
+
+        const char* data;
+        size_t length;
+        bool mapped;  // otherwise, data was made by new[]
+        off_t size;
+        time_t modified;
+        ino_t inode;
+    };
+
+    // Smaller files are read into memory, as mapping them saves little.
+    static const size_t MinMappedLength = 64 * 1024;
+
+    static const size_t DefaultMaxFiles = 1024;
+    static const size_t DefaultMaxBytes = 64 * 1024 * 1024;
+
+    IncludeFileCache(size_t maxFiles = DefaultMaxFiles, size_t maxBytes = DefaultMaxBytes) :
+        maxFiles(maxFiles), maxBytes(maxBytes), bytes(0) { }
+
+    // Get the contents of the file at 'path', or nullptr if there is no such file.
+    std::shared_ptr<const File> getFile(const std::string& path)
+    {
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0 || (status.st_mode & S_IFMT) != S_IFREG) {
+            std::lock_guard<std::mutex> lock(mutex);
+            drop(path);
+            return nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto entry = files.find(path);
+            if (entry != files.end() && entry->second.file->isCurrent(status)) {
+                uses.splice(uses.begin(), uses, entry->second.use);
+                return entry->second.file;
+            }
+        }
+
+        std::shared_ptr<File> file = readFile(path);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        drop(path);
+        if (file == nullptr)
+            return nullptr;
+        uses.push_front(path);
+        files[path] = { file, uses.begin() };
+        bytes += file->getLength();
+        while (files.size() > maxFiles || (bytes > maxBytes && files.size() > 1))
+            drop(uses.back());
+
+        return file;
+    }
+
+    size_t getFileCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return files.size();
+    }
+
+    size_t getByteCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return bytes;
+    }
+
+    // Forget all files.  Contents still in use stay valid until released.
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        files.clear();
+        uses.clear();
+        bytes = 0;
+    }
+
+protected:
+    IncludeFileCache(const IncludeFileCache&);
+    IncludeFileCache& operator=(const IncludeFileCache&);
+
+    struct Entry {
+        std::shared_ptr<const File> file;
+        std::list<std::string>::iterator use;
+    };
+
+    // Forget the file at 'path', if held.  The mutex must be locked.
+    void drop(const std::string& path)
+    {
+        const auto entry = files.find(path);
+        if (entry == files.end())
+            return;
+        bytes -= entry->second.file->getLength();
+        uses.erase(entry->second.use);
+        files.erase(entry);
+    }
+
+    static std::shared_ptr<File> readFile(const std::string& path)
+    {
+        std::shared_ptr<File> file = std::make_shared<File>();
+        struct stat status;
+#ifndef _WIN32
+        const int descriptor = open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return nullptr;
+        if (fstat(descriptor, &status) != 0) {
+            close(descriptor);
+            return nullptr;
+        }
+        file->length = (size_t)status.st_size;
+        if (file->length >= MinMappedLength) {
+            void* data = mmap(nullptr, file->length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (data == MAP_FAILED) {
+                close(descriptor);
+                return nullptr;
+            }
+            file->data = static_cast<const char*>(data);
+            file->mapped = true;
+        } else if (file->length > 0) {
+            char* data = new char[file->length];
+            file->data = data;
+            for (size_t done = 0; done < file->length; ) {
+                const ssize_t count = pread(descriptor, data + done, file->length - done, (off_t)done);
+                if (count <= 0) {
+                    close(descriptor);
+                    return nullptr;
+                }
+                done += (size_t)count;
+            }
+        }
+        close(descriptor);
+#else
+        std::ifstream stream(path, std::ios_base::binary | std::ios_base::ate);
+        if (! stream || stat(path.c_str(), &status) != 0)
+            return nullptr;
+        file->length = (size_t)stream.tellg();
+        char* data = new char[file->length];
+        stream.seekg(0, stream.beg);
+        stream.read(data, file->length);
+        file->data = data;
+#endif
+        file->size = status.st_size;
+        file->modified = status.st_mtime;
+        file->inode = status.st_ino;
+
+        return file;
+    }
+
+    const size_t maxFiles;
+    const size_t maxBytes;
+    std::mutex mutex;
+    std::map<std::string, Entry> files;  // by path
+    std::list<std::string> uses;         // paths of 'files', most recently used first
+    size_t bytes;                        // total length of 'files'
+};
+
+// A DirStackFileIncluder getting files from an IncludeFileCache, which can be
+// shared with other includers, on other threads.  Each includer is still for
+// one compile at a time.
+class CachingDirStackFileIncluder : public DirStackFileIncluder {
+public:
+    CachingDirStackFileIncluder(IncludeFileCache& cache) : cache(cache) { }
+
+    virtual void releaseInclude(IncludeResult* result) override
+    {
+        if (result != nullptr) {
+            delete static_cast<std::shared_ptr<const IncludeFileCache::File>*>(result->userData);
+            delete result;
+        }
+    }
+
+    virtual ~CachingDirStackFileIncluder() override { }
+
+protected:
+    IncludeFileCache& cache;
+
+    // As DirStackFileIncluder::readLocalPath().  The search is done every time,
+    // so a header added earlier in it is found, but it costs only a stat() of
+    // each path tried.
+    virtual IncludeResult* readLocalPath(const char* headerName, const char* includerName, int depth) override
+    {
+        directoryStack.resize(depth + externalLocalDirectoryCount);
+        if (depth == 1)
+            directoryStack.back() = getDirectory(includerName);
+
+        std::string path;
+        std::shared_ptr<const IncludeFileCache::File> file;
+        for (auto it = directoryStack.rbegin(); file == nullptr && it != directoryStack.rend(); ++it) {
+            path = *it + '/' + headerName;
+            std::replace(path.begin(), path.end(), '\\', '/');
+            file = cache.getFile(path);
+        }
+        if (file == nullptr)
+            return nullptr;
+
+        directoryStack.push_back(getDirectory(path));
+        return new IncludeResult(path, file->getData(), file->getLength(),
+                                 new std::shared_ptr<const IncludeFileCache::File>(file));
+    }
+};
@@ -55,7 +55,11 @@
 #include <cctype>
 #include <cmath>
 #include <array>
+#include <atomic>
+#include <iostream>
+#include <map>
 #include <memory>
+#include <sstream>
 #include <thread>
 
 #include "../glslang/OSDependent/osinclude.h"
@@ -94,6 +98,9 @@ enum TOptions {
     EOptionHlslIoMapping        = (1 << 24),
     EOptionAutoMapLocations     = (1 << 25),
     EOptionDebug                = (1 << 26),
+    EOptionPoolStats            = (1 << 27),
+    EOptionIncludeCache         = (1 << 28),
+    EOptionSeparatePrograms     = (1 << 29),
 };
 
 //
@@ -120,8 +127,11 @@ void FreeFileData(char* data);
 void InfoLogMsg(const char* msg, const char* name, const int num);
 
 // Globally track if any compile or link failure.
-bool CompileFailed = false;
-bool LinkFailed = false;
+std::atomic<bool> CompileFailed(false);
+std::atomic<bool> LinkFailed(false);
+
+// Number of threads for multi-threaded mode.
+int NumThreads = 16;
 
 TBuiltInResource Resources;
 std::string ConfigFile;
@@ -147,7 +157,11 @@ const char* entryPointName = nullptr;
 const char* sourceEntryPointName = nullptr;
 const char* shaderStageName = nullptr;
 const char* variableName = nullptr;
+const char* builtInCacheFileName = nullptr;
 std::vector<std::string> IncludeDirectoryList;
+IncludeFileCache IncludeFiles;  // for --include-cache
+std::map<std::string, glslang::TScannedSource> ScannedSources; // for --include-cache, by file name, made
+                                                               // before any threads start
 int ClientInputSemanticsVersion = 100;   // maps to, say, #define VULKAN 100
 int VulkanClientVersion = 100;           // would map to, say, Vulkan 1.0
 int OpenGLClientVersion = 450;           // doesn't influence anything yet, but maps to OpenGL 4.50
@@ -397,6 +411,11 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
                     } else if (lowerword == "auto-map-locations" || // synonyms
                                lowerword == "aml") {
                         Options |= EOptionAutoMapLocations;
+                    } else if (lowerword == "builtin-cache") {
+                        if (argc <= 1)
+                            Error("no <file> provided for --builtin-cache");
+                        builtInCacheFileName = argv[1];
+                        bumpArg();
                     } else if (lowerword == "client") {
                         if (argc > 1) {
                             if (strcmp(argv[1], "vulkan100") == 0)
@@ -417,16 +436,22 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
                                lowerword == "hlsl-iomapper" ||
                                lowerword == "hlsl-iomapping") {
                         Options |= EOptionHlslIoMapping;
+                    } else if (lowerword == "include-cache") {
+                        Options |= EOptionIncludeCache;
                     } else if (lowerword == "keep-uncalled" || // synonyms
                                lowerword == "ku") {
                         Options |= EOptionKeepUncalled;
                     } else if (lowerword == "no-storage-format" || // synonyms
                                lowerword == "nsf") {
                         Options |= EOptionNoStorageFormat;
+                    } else if (lowerword == "pool-stats") {
+                        Options |= EOptionPoolStats;
                     } else if (lowerword == "resource-set-bindings" ||  // synonyms
                                lowerword == "resource-set-binding"  ||
                                lowerword == "rsb") {
                         ProcessResourceSetBindingBase(argc, argv, baseResourceSetBinding);
+                    } else if (lowerword == "separate-programs") {
+                        Options |= EOptionSeparatePrograms;
                     } else if (lowerword == "shift-image-bindings" ||  // synonyms
                                lowerword == "shift-image-binding"  ||
                                lowerword == "sib") {
@@ -551,6 +576,14 @@ void ProcessArguments(std::vector<std::unique_ptr<glslang::TWorkItem>>& workItem
             case 'i':
                 Options |= EOptionIntermediate;
                 break;
+            case 'j':
+                if (argc <= 1)
+                    Error("no <num> provided for -j");
+                NumThreads = atoi(argv[1]);
+                if (NumThreads < 1)
+                    Error("-j requires a positive number of threads");
+                bumpArg();
+                break;
             case 'l':
                 Options |= EOptionLinkProgram;
                 break;
@@ -667,6 +700,23 @@ void PutsIfNonEmpty(const char* str)
     }
 }
 
+// As above, but to the given stream.
+void PutsIfNonEmpty(std::ostream& out, const char* str)
+{
+    if (str && str[0])
+        out << str << "\n";
+}
+
+// Outputs what the pool allocator(s) of 'what' used.
+void PutsPoolStats(std::ostream& out, const char* what, const glslang::TPoolStats& stats)
+{
+    out << what << " pool: " << stats.numAllocations << " allocations of " << stats.bytesRequested << " bytes; "
+        << stats.peakBytesInUse << " bytes at peak, " << stats.bytesReserved << " reserved; "
+        << stats.pagesInUse << " pages in use, " << stats.freePages << " free; "
+        << stats.multiPageAllocations << " multi-page allocations, largest " << stats.largestMultiPageAllocation << " bytes; "
+        << "push depth " << stats.pushDepth << ", at most " << stats.maxPushDepth << "\n";
+}
+
 // Outputs the given string to stderr, but only if it is non-null and non-empty.
 // This prevents erroneous newlines from appearing.
 void StderrIfNonEmpty(const char* str)
@@ -715,12 +765,23 @@ struct ShaderCompUnit {
 //
 // Uses the new C++ interface instead of the old handle-based interface.
 //
+// Reports go to 'out'.  If 'binaryName' is non-null, it names the binary instead of
+// GetBinaryName().
+//
 
-void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
+void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits, std::ostream& out,
+                               const char* binaryName = nullptr, int numThreads = 1)
 {
+    bool compileFailed = false;
+    bool linkFailed = false;
+
     // keep track of what to free
     std::list<glslang::TShader*> shaders;
 
+    // The shaders are parsed up to numThreads at a time, each with an includer of its own.
+    std::vector<std::unique_ptr<DirStackFileIncluder>> includers;
+    std::unique_ptr<glslang::TCompileBatch> batch(new glslang::TCompileBatch(numThreads));
+
     EShMessages messages = EShMsgDefault;
     SetMessageOptions(messages);
 
@@ -739,6 +800,8 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
             shader->setSourceEntryPoint(sourceEntryPointName);
         if (UserPreamble.isSet())
             shader->setPreamble(UserPreamble.get());
+        if (Options & EOptionIncludeCache)
+            shader->setScannedSource(&ScannedSources.at(compUnit.fileName[0]));
 
         shader->setShiftSamplerBinding(baseSamplerBinding[compUnit.stage]);
         shader->setShiftTextureBinding(baseTextureBinding[compUnit.stage]);
@@ -781,53 +844,85 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
 
         const int defaultVersion = Options & EOptionDefaultDesktop ? 110 : 100;
 
-        DirStackFileIncluder includer;
+        includers.push_back(std::unique_ptr<DirStackFileIncluder>((Options & EOptionIncludeCache) ?
+                                                                  new CachingDirStackFileIncluder(IncludeFiles) :
+                                                                  new DirStackFileIncluder));
+        DirStackFileIncluder& includer = *includers.back();
         std::for_each(IncludeDirectoryList.rbegin(), IncludeDirectoryList.rend(), [&includer](const std::string& dir) {
             includer.pushExternalLocalDirectory(dir); });
         if (Options & EOptionOutputPreprocessed) {
             std::string str;
             if (shader->preprocess(&Resources, defaultVersion, ENoProfile, false, false,
                                    messages, &str, includer)) {
-                PutsIfNonEmpty(str.c_str());
+                PutsIfNonEmpty(out, str.c_str());
             } else {
-                CompileFailed = true;
+                compileFailed = true;
             }
             StderrIfNonEmpty(shader->getInfoLog());
             StderrIfNonEmpty(shader->getInfoDebugLog());
             continue;
         }
-        if (! shader->parse(&Resources, defaultVersion, false, messages, includer))
-            CompileFailed = true;
 
-        program.addShader(shader);
+        glslang::TCompileBatch::TJob job;
+        job.shaders.push_back(shader);
+        job.resources = &Resources;
+        job.defaultVersion = defaultVersion;
+        job.messages = messages;
+        job.includer = &includer;
+        job.link = false;
+        batch->add(job);
+    }
+
+    batch->run();
+
+    auto shader = shaders.cbegin();
+    for (int j = 0; j < batch->getNumJobs(); ++j, ++shader) {
+        if (! batch->getSuccess(j))
+            compileFailed = true;
 
+        program.addShader(*shader);
+
+        const std::string& fileName = compUnits[j].fileName[0];
         if (! (Options & EOptionSuppressInfolog) &&
             ! (Options & EOptionMemoryLeakMode)) {
-            PutsIfNonEmpty(compUnit.fileName[0].c_str());
-            PutsIfNonEmpty(shader->getInfoLog());
-            PutsIfNonEmpty(shader->getInfoDebugLog());
+            PutsIfNonEmpty(out, fileName.c_str());
+            PutsIfNonEmpty(out, (*shader)->getInfoLog());
+            PutsIfNonEmpty(out, (*shader)->getInfoDebugLog());
+        }
+
+        if (Options & EOptionPoolStats) {
+            glslang::TPoolStats stats;
+            (*shader)->getPoolStats(stats);
+            PutsPoolStats(out, fileName.c_str(), stats);
         }
     }
+    batch.reset();
 
     //
     // Program-level processing...
     //
 
     // Link
-    if (! (Options & EOptionOutputPreprocessed) && ! program.link(messages))
-        LinkFailed = true;
+    if (! (Options & EOptionOutputPreprocessed) && ! program.link(messages, numThreads))
+        linkFailed = true;
 
     // Map IO
     if (Options & EOptionSpv) {
         if (!program.mapIO())
-            LinkFailed = true;
+            linkFailed = true;
     }
 
     // Report
     if (! (Options & EOptionSuppressInfolog) &&
         ! (Options & EOptionMemoryLeakMode)) {
-        PutsIfNonEmpty(program.getInfoLog());
-        PutsIfNonEmpty(program.getInfoDebugLog());
+        PutsIfNonEmpty(out, program.getInfoLog());
+        PutsIfNonEmpty(out, program.getInfoDebugLog());
+    }
+
+    if (Options & EOptionPoolStats) {
+        glslang::TPoolStats stats;
+        program.getPoolStats(stats);
+        PutsPoolStats(out, "Linking", stats);
     }
 
     // Reflect
@@ -838,8 +933,8 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
 
     // Dump SPIR-V
     if (Options & EOptionSpv) {
-        if (CompileFailed || LinkFailed)
-            printf("SPIR-V is not generated for failed compile or link\n");
+        if (compileFailed || linkFailed)
+            out << "SPIR-V is not generated for failed compile or link\n";
         else {
             for (int stage = 0; stage < EShLangCount; ++stage) {
                 if (program.getIntermediate((EShLanguage)stage)) {
@@ -854,14 +949,15 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
                     // Dump the spv to a file or stdout, etc., but only if not doing
                     // memory/perf testing, as it's not internal to programmatic use.
                     if (! (Options & EOptionMemoryLeakMode)) {
-                        printf("%s", logger.getAllMessages().c_str());
+                        out << logger.getAllMessages();
+                        const char* name = binaryName != nullptr ? binaryName : GetBinaryName((EShLanguage)stage);
                         if (Options & EOptionOutputHexadecimal) {
-                            glslang::OutputSpvHex(spirv, GetBinaryName((EShLanguage)stage), variableName);
+                            glslang::OutputSpvHex(spirv, name, variableName);
                         } else {
-                            glslang::OutputSpvBin(spirv, GetBinaryName((EShLanguage)stage));
+                            glslang::OutputSpvBin(spirv, name);
                         }
                         if (Options & EOptionHumanReadableSpv) {
-                            spv::Disassemble(std::cout, spirv);
+                            spv::Disassemble(out, spirv);
                         }
                     }
                 }
@@ -878,6 +974,11 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
         delete shaders.back();
         shaders.pop_back();
     }
+
+    if (compileFailed)
+        CompileFailed = true;
+    if (linkFailed)
+        LinkFailed = true;
 }
 
 //
@@ -888,8 +989,9 @@ void CompileAndLinkShaderUnits(std::vector<ShaderCompUnit> compUnits)
 // This is just for linking mode: meaning all the shaders will be put into the
 // the same program linked together.
 //
-// This means there are a limited number of work items (not multi-threading mode)
-// and that the point is testing at the linking level. Hence, to enable
+// This means there are a limited number of work items (with -t, parsed and
+// linked by stage in parallel) and that the point is testing at the linking
+// level. Hence, to enable
 // performance and memory testing, the actual compile/link can be put in
 // a loop, independent of processing the work items and file IO.
 //
@@ -917,7 +1019,8 @@ void CompileAndLinkShaderFiles(glslang::TWorklist& Worklist)
     // all the perf/memory that a programmatic consumer will care about.
     for (int i = 0; i < ((Options & EOptionMemoryLeakMode) ? 100 : 1); ++i) {
         for (int j = 0; j < ((Options & EOptionMemoryLeakMode) ? 100 : 1); ++j)
-           CompileAndLinkShaderUnits(compUnits);
+           CompileAndLinkShaderUnits(compUnits, std::cout, nullptr,
+                                     (Options & EOptionMultiThreaded) ? NumThreads : 1);
 
         if (Options & EOptionMemoryLeakMode)
             glslang::OS_DumpMemoryCounters();
@@ -929,16 +1032,81 @@ void CompileAndLinkShaderFiles(glslang::TWorklist& Worklist)
         FreeFileData(const_cast<char*>(it->text[0]));
 }
 
+//
+// For --separate-programs: each file is a program of its own, parsed, linked, and
+// turned into SPIR-V independently of the others, on up to NumThreads threads with -t.
+// What each would print is collected, then printed in the order of the files.
+//
+void CompileAndLinkShaderFilesConcurrently(glslang::TWorklist& Worklist)
+{
+    std::vector<ShaderCompUnit> compUnits;
+
+    // Read all the files up front, as errors exit.
+    glslang::TWorkItem* workItem;
+    while (Worklist.remove(workItem)) {
+        ShaderCompUnit compUnit(FindLanguage(workItem->name));
+        char* fileText = ReadFileData(workItem->name.c_str());
+        if (fileText == nullptr)
+            usage();
+        compUnit.addString(workItem->name, fileText);
+        compUnits.push_back(compUnit);
+    }
+
+    // With one binary per file, -o can only name one.
+    if (binaryFileName != nullptr && compUnits.size() > 1)
+        Error("-o can't be used with --separate-programs on more than one file");
+
+    // Set up what SPIR-V disassembly uses before threads race to.
+    if (Options & EOptionHumanReadableSpv)
+        spv::Parameterize();
+
+    std::vector<std::string> outputs(compUnits.size());
+    std::atomic<int> next(0);
+
+    // Each thread takes the next file not yet taken, until there are none.
+    const auto compileSome = [&]() {
+        for (int u = next++; u < (int)compUnits.size(); u = next++) {
+            std::ostringstream out;
+            std::string binaryName = compUnits[u].fileName[0] + ".spv";
+            CompileAndLinkShaderUnits(std::vector<ShaderCompUnit>(1, compUnits[u]), out,
+                                      binaryFileName == nullptr ? binaryName.c_str() : nullptr);
+            outputs[u] = out.str();
+        }
+    };
+
+    // The calling thread is one of them.
+    std::vector<std::thread> threads;
+    const int numThreads = (Options & EOptionMultiThreaded) ? NumThreads : 1;
+    for (int t = 1; t < std::min(numThreads, (int)compUnits.size()); ++t) {
+        threads.push_back(std::thread(compileSome));
+        if (threads.back().get_id() == std::thread::id()) {
+            printf("Failed to create thread\n");
+            threads.pop_back();
+            break;
+        }
+    }
+    compileSome();
+    std::for_each(threads.begin(), threads.end(), [](std::thread& t) { t.join(); });
+
+    for (auto it = outputs.begin(); it != outputs.end(); ++it)
+        fputs(it->c_str(), stdout);
+
+    // free memory from ReadFileData
+    for (auto it = compUnits.begin(); it != compUnits.end(); ++it)
+        FreeFileData(const_cast<char*>(it->text[0]));
+}
+
 int C_DECL main(int argc, char* argv[])
 {
     // array of unique places to leave the shader names and infologs for the asynchronous compiles
     std::vector<std::unique_ptr<glslang::TWorkItem>> workItems;
     ProcessArguments(workItems, argc, argv);
 
-    glslang::TWorklist workList;
+    glslang::TWorklist workList((int)workItems.size());
     std::for_each(workItems.begin(), workItems.end(), [&workList](std::unique_ptr<glslang::TWorkItem>& item) {
         assert(item);
-        workList.add(item.get());
+        if (! workList.add(item.get()))
+            Error("work list is full");
     });
 
     if (Options & EOptionDumpConfig) {
@@ -969,23 +1137,49 @@ int C_DECL main(int argc, char* argv[])
     ProcessConfigFile();
 
     //
-    // Two modes:
-    // 1) linking all arguments together, single-threaded, new C++ interface
-    // 2) independent arguments, can be tackled by multiple asynchronous threads, for testing thread safety, using the old handle interface
+    // Three modes:
+    // 1) linking all arguments together, optionally multi-threaded, new C++ interface
+    // 2) linking each argument on its own, optionally multi-threaded, new C++ interface
+    // 3) independent arguments, can be tackled by multiple asynchronous threads, for testing thread safety, using the old handle interface
     //
+    // Load built-in symbol tables saved by an earlier run, or save them for the next run.
+    bool builtInCacheLoaded = false;
+    const auto loadBuiltInCache = [&builtInCacheLoaded]() {
+        if (builtInCacheFileName != nullptr)
+            builtInCacheLoaded = glslang::LoadBuiltInSymbolTables(builtInCacheFileName);
+    };
+    const auto saveBuiltInCache = [&builtInCacheLoaded]() {
+        if (builtInCacheFileName != nullptr && ! builtInCacheLoaded &&
+            ! glslang::SaveBuiltInSymbolTables(builtInCacheFileName))
+            printf("Failed to save built-in symbol tables to %s\n", builtInCacheFileName);
+    };
+
+    if (Options & EOptionIncludeCache) {
+        glslang::SetIncludeCacheSize(16 * 1024 * 1024);
+        for (const auto& item : workItems)
+            ScannedSources[item->name];
+    }
+
     if (Options & EOptionLinkProgram ||
         Options & EOptionOutputPreprocessed) {
         glslang::InitializeProcess();
-        CompileAndLinkShaderFiles(workList);
+        loadBuiltInCache();
+        if ((Options & EOptionSeparatePrograms) &&
+            ! (Options & (EOptionOutputPreprocessed | EOptionMemoryLeakMode | EOptionDumpReflection)))
+            CompileAndLinkShaderFilesConcurrently(workList);
+        else
+            CompileAndLinkShaderFiles(workList);
+        saveBuiltInCache();
         glslang::FinalizeProcess();
     } else {
         ShInitialize();
+        loadBuiltInCache();
 
         bool printShaderNames = workList.size() > 1;
 
         if (Options & EOptionMultiThreaded)
         {
-            std::array<std::thread, 16> threads;
+            std::vector<std::thread> threads(NumThreads);
             for (unsigned int t = 0; t < threads.size(); ++t)
             {
                 threads[t] = std::thread(CompileShaders, std::ref(workList));
@@ -1009,6 +1203,7 @@ int C_DECL main(int argc, char* argv[])
             }
         }
 
+        saveBuiltInCache();
         ShFinalize();
     }
 
@@ -1160,13 +1355,15 @@ void usage()
            "  -g          generate debug information\n"
            "  -h          print this usage message\n"
            "  -i          intermediate tree (glslang AST) is printed out\n"
+           "  -j <num>    number of threads for -t (default is 16)\n"
            "  -l          link all input files together to form a single module\n"
            "  -m          memory leak mode\n"
            "  -o  <file>  save binary to <file>, requires a binary option (e.g., -V)\n"
            "  -q          dump reflection query database\n"
            "  -r          relaxed semantic error-checking mode\n"
            "  -s          silent mode\n"
-           "  -t          multi-threaded mode\n"
+           "  -t          multi-threaded mode; with -l, -V, or -G, parses the files and\n"
+           "              links the stages in parallel; see also --separate-programs\n"
            "  -v          print version strings\n"
            "  -w          suppress warnings (except as required by #extension : warn)\n"
            "  -x          save binary output as text-based 32-bit hexadecimal numbers\n"
@@ -1176,6 +1373,9 @@ void usage()
            "  --auto-map-locations                 automatically locate input/output lacking\n"
            "                                       'location' (fragile, not cross stage)\n"
            "  --aml                                synonym for --auto-map-locations\n"
+           "  --builtin-cache <file>               load built-in symbol tables from <file>;\n"
+           "                                       if that fails, save them to <file> for\n"
+           "                                       the next run\n"
            "  --client {vulkan<ver>|opengl<ver>}   see -V and -G\n"
            "  --flatten-uniform-arrays             flatten uniform texture/sampler arrays to\n"
            "                                       scalars\n"
@@ -1183,12 +1383,24 @@ void usage()
            "  --hlsl-offsets                       Allow block offsets to follow HLSL rules\n"
            "                                       Works independently of source language\n"
            "  --hlsl-iomap                         Perform IO mapping in HLSL register space\n"
+           "  --include-cache                      reuse the files and tokens of headers\n"
+           "                                       #included more than once, and of shader\n"
+           "                                       files given more than once, across shaders;\n"
+           "                                       headers of 64K or more are memory mapped,\n"
+           "                                       and must not be truncated while compiling\n"
            "  --keep-uncalled                      don't eliminate uncalled functions\n"
            "  --ku                                 synonym for --keep-uncalled\n"
            "  --no-storage-format                  use Unknown image format\n"
            "  --nsf                                synonym for --no-storage-format\n"
+           "  --pool-stats                         print the pool memory used by each\n"
+           "                                       shader and by linking\n"
            "  --resource-set-binding [stage] num   descriptor set and binding for resources\n"
            "  --rsb [stage] type set binding       synonym for --resource-set-binding\n"
+           "  --separate-programs                  with -l, -V, or -G, link each file into a\n"
+           "                                       program of its own, in parallel with -t,\n"
+           "                                       saving the binary to <file>.spv (-o\n"
+           "                                       overrides this for a single file); not\n"
+           "                                       used with -E, -m, or -q\n"
            "  --shift-image-binding [stage] num    base binding number for images (uav)\n"
            "  --sib [stage] num                    synonym for --shift-image-binding\n"
            "  --shift-sampler-binding [stage] num  base binding number for samplers\n"
@@ -36,8 +36,10 @@
 #define WORKLIST_H_INCLUDED
 
 #include "../glslang/OSDependent/osinclude.h"
-#include <list>
-#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 namespace glslang {
@@ -52,42 +54,102 @@ namespace glslang {
         std::string resultsIndex;
     };
 
+    //
+    // Bounded, lock-free, multi-producer multi-consumer queue of work items.
+    //
+    // Each cell has a sequence number saying whose turn it is: when it equals the
+    // position of an add(), the cell is free for that add(); when it is one past the
+    // position of a remove(), the cell holds the item for that remove().  Producers
+    // and consumers each claim positions by bumping their own counter.
+    //
     class TWorklist {
     public:
-        TWorklist() { }
+        explicit TWorklist(int capacity) : enqueuePos(0), dequeuePos(0)
+        {
+            size_t size = 1;
+            while (size < (size_t)capacity)
+                size <<= 1;
+            mask = size - 1;
+            cells.reset(new TCell[size]);
+            for (size_t c = 0; c < size; ++c)
+                cells[c].sequence.store(c, std::memory_order_relaxed);
+        }
         virtual ~TWorklist() { }
 
-        void add(TWorkItem* item)
+        // Returns false if the worklist is full.
+        bool add(TWorkItem* item)
         {
-            std::lock_guard<std::mutex> guard(mutex);
-            worklist.push_back(item);
+            TCell* cell;
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                cell = &cells[pos & mask];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                intptr_t turn = (intptr_t)sequence - (intptr_t)pos;
+                if (turn == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (turn < 0)
+                    return false;
+                else
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+            cell->item = item;
+            cell->sequence.store(pos + 1, std::memory_order_release);
+
+            return true;
         }
 
         bool remove(TWorkItem*& item)
         {
-            std::lock_guard<std::mutex> guard(mutex);
-
-            if (worklist.empty())
-                return false;
-            item = worklist.front();
-            worklist.pop_front();
+            TCell* cell;
+            size_t pos = dequeuePos.load(std::memory_order_relaxed);
+            for (;;) {
+                cell = &cells[pos & mask];
+                size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                intptr_t turn = (intptr_t)sequence - (intptr_t)(pos + 1);
+                if (turn == 0) {
+                    if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (turn < 0)
+                    return false;
+                else
+                    pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+            item = cell->item;
+            cell->sequence.store(pos + mask + 1, std::memory_order_release);
 
             return true;
         }
 
+        // Only a snapshot, while other threads are adding or removing.
         int size()
         {
-            return (int)worklist.size();
+            size_t removed = dequeuePos.load(std::memory_order_acquire);
+            size_t added = enqueuePos.load(std::memory_order_acquire);
+
+            return added > removed ? (int)(added - removed) : 0;
         }
 
         bool empty()
         {
-            return worklist.empty();
+            return size() == 0;
         }
 
     protected:
-        std::mutex mutex;
-        std::list<TWorkItem*> worklist;
+        TWorklist(TWorklist&);
+        TWorklist& operator=(TWorklist&);
+
+        struct TCell {
+            std::atomic<size_t> sequence;
+            TWorkItem* item;
+        };
+
+        std::unique_ptr<TCell[]> cells;
+        size_t mask;
+
+        // Kept on their own cache lines, as producers and consumers hammer them separately.
+        alignas(64) std::atomic<size_t> enqueuePos;
+        alignas(64) std::atomic<size_t> dequeuePos;
     };
 
 } // end namespace glslang
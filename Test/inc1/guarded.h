@@ -0,0 +1,14 @@
+// Only comments and white space are outside the guard.
+
+#ifndef GUARDED_H
+#define GUARDED_H
+
+float g1;
+
+#if 1
+float g2;
+#else
+float g3;
+#endif
+
+#endif // GUARDED_H
@@ -0,0 +1,6 @@
+#ifndef NOT_GUARDED_H
+#define NOT_GUARDED_H
+float n1;
+#else
+float n2;
+#endif
@@ -0,0 +1,5 @@
+#ifndef TRAILING_H
+#define TRAILING_H
+float t1;
+#endif
+TRAILING_DECL
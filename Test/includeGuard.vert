@@ -0,0 +1,28 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+
+#include "inc1/guarded.h"
+#include "inc1/guarded.h"
+
+#include "inc1/once.h"
+#include "inc1/once.h"
+
+#include "inc1/notGuarded.h"
+#include "inc1/notGuarded.h"
+
+#define TRAILING_DECL float t2;
+#include "inc1/trailing.h"
+#undef TRAILING_DECL
+#define TRAILING_DECL float t3;
+#include "inc1/trailing.h"
+
+#undef GUARDED_H
+#define g1 g4
+#define g2 g5
+#include "inc1/guarded.h"
+
+void main()
+{
+    gl_Position = vec4(g1 + g2 + o1 + n1 + n2 + t1 + t2 + t3);
+}
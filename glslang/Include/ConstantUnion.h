@@ -37,8 +37,16 @@
 #ifndef _CONSTANT_UNION_INCLUDED_
 #define _CONSTANT_UNION_INCLUDED_
 
+#include <cstring>
+
 namespace glslang {
 
+// Large constant arrays are vectors of these, so leave out the padding an
+// 8-byte aligned union would need after the 4-byte type: 12 bytes, not 16.
+// The 8-byte members are then only 4-byte aligned, which all targets
+// handle for ordinary loads and stores.
+#pragma pack(push, 4)
+
 class TConstUnion {
 public:
     POOL_ALLOCATOR_NEW_DELETE(GetThreadPoolAllocator())
@@ -95,6 +103,31 @@ public:
     bool               getBConst() const   { return bConst; }
     const TString*     getSConst() const   { return sConst; }
 
+    // The exact bits of the value, for finding identical constants.
+    unsigned long long getBits() const
+    {
+        switch (type) {
+        case EbtInt:    return (unsigned int)iConst;
+        case EbtUint:   return uConst;
+        case EbtInt64:  return (unsigned long long)i64Const;
+        case EbtUint64: return u64Const;
+        case EbtBool:   return bConst ? 1 : 0;
+        case EbtDouble:
+        {
+            unsigned long long bits;
+            memcpy(&bits, &dConst, sizeof(bits));
+            return bits;
+        }
+        default:        return (unsigned long long)(uintptr_t)sConst;
+        }
+    }
+
+    // Unlike operator==, this tells 0.0 from -0.0, and strings by pointer.
+    bool identical(const TConstUnion& constant) const
+    {
+        return constant.type == type && constant.getBits() == getBits();
+    }
+
     bool operator==(const int i) const
     {
         if (i == iConst)
@@ -545,6 +578,8 @@ private:
     TBasicType type;
 };
 
+#pragma pack(pop)
+
 // Encapsulate having a pointer to an array of TConstUnion,
 // which only needs to be allocated if its size is going to be
 // bigger than 0.
@@ -560,7 +595,7 @@ public:
     POOL_ALLOCATOR_NEW_DELETE(GetThreadPoolAllocator())
 
     TConstUnionArray() : unionArray(nullptr) { }
-    virtual ~TConstUnionArray() { }
+    ~TConstUnionArray() { }
 
     explicit TConstUnionArray(int size)
     {
@@ -602,6 +637,34 @@ public:
     }
     bool operator!=(const TConstUnionArray& rhs) const { return ! operator==(rhs); }
 
+    // Hash and compare the exact contents, see TConstUnion::identical().
+    // Used to intern arrays, so equal constants share storage and
+    // operator== above can answer by identity.
+    static size_t hash(size_t h, const TConstUnion& c)
+    {
+        unsigned long long bits = c.getBits() ^ c.getType();
+        return (h ^ (size_t)(bits ^ (bits >> 32))) * 16777619u;
+    }
+    size_t hash() const
+    {
+        size_t h = 2166136261u;
+        for (int i = 0; i < size(); ++i)
+            h = hash(h, (*this)[i]);
+        return h;
+    }
+    bool identical(const TConstUnionArray& rhs) const
+    {
+        if (unionArray == rhs.unionArray)
+            return true;
+        if (size() != rhs.size())
+            return false;
+        for (int i = 0; i < size(); ++i) {
+            if (! (*this)[i].identical(rhs[i]))
+                return false;
+        }
+        return true;
+    }
+
     double dot(const TConstUnionArray& rhs)
     {
         assert(rhs.unionArray->size() == unionArray->size());
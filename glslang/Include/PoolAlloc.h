@@ -63,10 +63,14 @@
 
 #include <cstddef>
 #include <cstring>
+#include <new>
 #include <vector>
 
 namespace glslang {
 
+struct TPoolStats;
+struct TPoolConfig;
+
 // If we are using guard blocks, we must track each individual
 // allocation.  If we aren't using guard blocks, these
 // never get instantiated, so won't have any impact.
@@ -130,6 +134,15 @@ private:
 #   endif
 };
 
+//
+// Thrown by TPoolAllocator::allocate() when going over the limit given
+// to setLimit().
+//
+class TPoolLimitExceeded : public std::bad_alloc {
+public:
+    const char* what() const noexcept override { return "memory limit exceeded"; }
+};
+
 //
 // There are several stacks.  One is to track the pushing and popping
 // of the user, and not yet implemented.  The others are simply a
@@ -137,16 +150,24 @@ private:
 //
 // Page stacks are linked together with a simple header at the beginning
 // of each allocation obtained from the underlying OS.  Multi-page allocations
-// are returned to the OS.  Individual page allocations are kept for future
-// re-use.
+// are kept in a small cache shared by all pools, for re-use by later
+// compiles, or returned to the OS.  Individual page allocations are kept for
+// future re-use, and when the pool is destroyed, kept for the next pools
+// made on the same thread.
 //
 // The "page size" used is not, nor must it match, the underlying OS
 // page size.  But, having it be about that size or equal to a set of
-// pages is likely most optimal.
+// pages is likely most optimal.  Each new page is twice the size of the
+// last one, up to a limit, so big shaders don't need many small pages.
+// See TPoolConfig in ShaderLang.h.
 //
 class TPoolAllocator {
 public:
-    TPoolAllocator(int growthIncrement = 8*1024, int allocationAlignment = 16);
+    //
+    // A growthIncrement of 0 means use the process's TPoolConfig, otherwise
+    // all pages are that size.
+    //
+    TPoolAllocator(int growthIncrement = 0, int allocationAlignment = 16);
 
     //
     // Don't call the destructor just to free up the memory, call pop()
@@ -176,6 +197,27 @@ public:
     //
     void* allocate(size_t numBytes);
 
+    //
+    // Limit the memory in pages in use to 'limit' bytes, 0 for no limit.
+    // A new page that would go over it makes allocate() throw
+    // TPoolLimitExceeded, after lifting the limit, so the memory needed
+    // while unwinding and reporting the error is still available.
+    //
+    void setLimit(size_t bytes) { limit = bytes; }
+
+    //
+    // Report memory use so far, see TPoolStats in ShaderLang.h.
+    //
+    void getStats(TPoolStats&) const;
+
+    //
+    // A pointer kept for the current push() level, e.g., to a table of
+    // objects allocated at that level.  push() starts each level with
+    // nullptr, and pop() gives back the one the outer level had.
+    //
+    void* getLevelData() const { return levelData; }
+    void setLevelData(void* data) { levelData = data; }
+
     //
     // There is no deallocate.  The point of this class is that
     // deallocation can be skipped by the user of it, as the model
@@ -187,11 +229,13 @@ protected:
     friend struct tHeader;
 
     struct tHeader {
-        tHeader(tHeader* nextPage, size_t pageCount) :
+        tHeader(tHeader* nextPage, size_t size, bool multiPage, unsigned int generation,
+                void (*freeMemory)(void*, void*, size_t), void* freeData) :
 #ifdef GUARD_BLOCKS
         lastAllocation(0),
 #endif
-        nextPage(nextPage), pageCount(pageCount) { }
+        nextPage(nextPage), size(size), multiPage(multiPage), generation(generation),
+        freeMemory(freeMemory), freeData(freeData) { }
 
         ~tHeader() {
 #ifdef GUARD_BLOCKS
@@ -204,12 +248,18 @@ protected:
         TAllocation* lastAllocation;
 #endif
         tHeader* nextPage;
-        size_t pageCount;
+        size_t size;            // in bytes, including this header
+        bool multiPage;         // a single allocation too big for a page
+        unsigned int generation; // of the allocator the page came from
+        void (*freeMemory)(void*, void*, size_t);  // how to give the page back, with freeData
+        void* freeData;
     };
 
     struct tAllocState {
         size_t offset;
+        size_t end;
         tHeader* page;
+        void* levelData;
     };
     typedef std::vector<tAllocState> tAllocStack;
 
@@ -226,7 +276,13 @@ protected:
         return TAllocation::offsetAllocation(memory);
     }
 
-    size_t pageSize;        // granularity of allocation from the OS
+    tHeader* newPage(size_t size, bool multiPage);
+    void freePage(tHeader*);
+    void addInUse(tHeader*);
+    void checkLimit(size_t pageSize);
+
+    size_t pageSize;        // granularity of allocation from the OS, for the next new page
+    size_t maxPageSize;     // pageSize doubles up to this
     size_t alignment;       // all returned allocations will be aligned at
                             //      this granularity, which will be a power of 2
     size_t alignmentMask;
@@ -234,12 +290,23 @@ protected:
                             //      header (basically, size of header, rounded
                             //      up to make it aligned
     size_t currentPageOffset;  // next offset in top of inUseList to allocate from
+    size_t currentPageEnd;     // size of top of inUseList, or 0 if not allocating from it
     tHeader* freeList;      // list of popped memory
     tHeader* inUseList;     // list of all memory currently being used
     tAllocStack stack;      // stack of where to allocate from, to partition pool
 
     int numCalls;           // just an interesting statistic
     size_t totalBytes;      // just an interesting statistic
+    int pagesInUse;         // pages in inUseList, a multi-page allocation counting as one
+    int freePages;          // pages in freeList
+    size_t bytesInUse;      // size of the pages in inUseList
+    size_t peakBytesInUse;
+    size_t freeBytes;       // size of the pages in freeList
+    int numMultiPageAllocations;
+    size_t largestMultiPageAllocation;
+    size_t maxStackDepth;
+    size_t limit;           // on bytesInUse, or 0
+    void* levelData;        // see getLevelData()
 private:
     TPoolAllocator& operator=(const TPoolAllocator&);  // don't allow assignment operator
     TPoolAllocator(const TPoolAllocator&);  // don't allow default copy constructor
@@ -251,7 +318,24 @@ private:
 // with everyone using the same global allocator.
 //
 typedef TPoolAllocator* PoolAllocatorPointer;
+
+//
+// Return the memory cached for multi-page allocations to the OS.
+//
+void FreeLargePageCache();
+
+//
+// Unless GLSLANG_OS_TLS_POOL_ALLOCATOR is defined (for toolchains without
+// thread_local), the current thread's allocator is also kept in a native
+// thread-local pointer, so getting it, as every pool allocation does, is
+// inlined rather than an OS TLS lookup.
+//
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+extern thread_local TPoolAllocator* ThreadPoolAllocator;
+inline TPoolAllocator& GetThreadPoolAllocator() { return *ThreadPoolAllocator; }
+#else
 extern TPoolAllocator& GetThreadPoolAllocator();
+#endif
 
 struct TThreadMemoryPools
 {
@@ -231,6 +231,8 @@ struct TSampler {   // misnomer now; includes images, textures without sampler,
 // Need to have association of line numbers to types in a list for building structs.
 //
 class TType;
+class TSymbolWriter;
+class TSymbolReader;
 struct TTypeLoc {
     TType* type;
     TSourceLoc loc;
@@ -1111,9 +1113,26 @@ public:
     bool isSubpass() const { return basicType == EbtSampler && sampler.isSubpass(); }
 };
 
+//
+// Types share their qualifiers, see TType.  These return a copy that is never
+// written: from a fixed table for a qualifier that is only a storage and
+// precision on a cleared one, else made once per push() level of the
+// thread's pool.
+//
+const TQualifier* GetClearedQualifier(TStorageQualifier, TPrecisionQualifier = EpqNone);
+const TQualifier* InternQualifier(const TQualifier&);
+
 //
 // Base class for things that have a type.
 //
+// The qualifier is held through a pointer, usually to an interned copy shared
+// with other types.  The non-const getQualifier() first gives the type its
+// own copy, from the current pool, so writing through it never changes
+// another type.  As that happens even for a read, read through a const type,
+// and change a shared qualifier with setQualifier() or editQualifier().  Types
+// that are shared read only across pools or threads get their own copy up
+// front; see unshareQualifiers().
+//
 class TType {
 public:
     POOL_ALLOCATOR_NEW_DELETE(GetThreadPoolAllocator())
@@ -1125,8 +1144,7 @@ public:
                             arraySizes(nullptr), structure(nullptr), fieldName(nullptr), typeName(nullptr)
                             {
                                 sampler.clear();
-                                qualifier.clear();
-                                qualifier.storage = q;
+                                shareQualifier(GetClearedQualifier(q));
                             }
     // for explicit precision qualifier
     TType(TBasicType t, TStorageQualifier q, TPrecisionQualifier p, int vs = 1, int mc = 0, int mr = 0,
@@ -1135,10 +1153,8 @@ public:
                             arraySizes(nullptr), structure(nullptr), fieldName(nullptr), typeName(nullptr)
                             {
                                 sampler.clear();
-                                qualifier.clear();
-                                qualifier.storage = q;
-                                qualifier.precision = p;
                                 assert(p >= EpqNone && p <= EpqHigh);
+                                shareQualifier(GetClearedQualifier(q, p));
                             }
     // for turning a TPublicType into a TType, using a shallow copy
     explicit TType(const TPublicType& p) :
@@ -1150,7 +1166,7 @@ public:
                                     sampler = p.sampler;
                                 else
                                     sampler.clear();
-                                qualifier = p.qualifier;
+                                shareQualifier(InternQualifier(p.qualifier));
                                 if (p.userDef) {
                                     structure = p.userDef->getWritableStruct();  // public type is short-lived; there are no sharing issues
                                     typeName = NewPoolTString(p.userDef->getTypeName().c_str());
@@ -1159,11 +1175,9 @@ public:
     // for construction of sampler types
     TType(const TSampler& sampler, TStorageQualifier q = EvqUniform, TArraySizes* as = nullptr) :
         basicType(EbtSampler), vectorSize(1), matrixCols(0), matrixRows(0), vector1(false),
-        arraySizes(as), structure(nullptr), fieldName(nullptr), typeName(nullptr),
-        sampler(sampler)
+        sampler(sampler), arraySizes(as), structure(nullptr), fieldName(nullptr), typeName(nullptr)
     {
-        qualifier.clear();
-        qualifier.storage = q;
+        shareQualifier(GetClearedQualifier(q));
     }
     // to efficiently make a dereferenced type
     // without ever duplicating the outer structure that will be thrown away
@@ -1210,18 +1224,19 @@ public:
                             arraySizes(nullptr), structure(userDef), fieldName(nullptr)
                             {
                                 sampler.clear();
-                                qualifier.clear();
+                                shareQualifier(GetClearedQualifier(EvqTemporary));
                                 typeName = NewPoolTString(n.c_str());
                             }
     // For interface blocks
     TType(TTypeList* userDef, const TString& n, const TQualifier& q) :
                             basicType(EbtBlock), vectorSize(1), matrixCols(0), matrixRows(0), vector1(false),
-                            qualifier(q), arraySizes(nullptr), structure(userDef), fieldName(nullptr)
+                            arraySizes(nullptr), structure(userDef), fieldName(nullptr)
                             {
                                 sampler.clear();
+                                shareQualifier(InternQualifier(q));
                                 typeName = NewPoolTString(n.c_str());
                             }
-    virtual ~TType() {}
+    ~TType() {}
 
     // Not for use across pool pops; it will cause multiple instances of TType to point to the same information.
     // This only works if that information (like a structure's list of types) does not change and
@@ -1230,7 +1245,10 @@ public:
     {
         basicType = copyOf.basicType;
         sampler = copyOf.sampler;
-        qualifier = copyOf.qualifier;
+        if (copyOf.sharedQualifier)
+            shareQualifier(copyOf.qualifier);  // copying the pointer only, as no type writes a shared qualifier
+        else
+            shareQualifier(InternQualifier(*copyOf.qualifier));
         vectorSize = copyOf.vectorSize;
         matrixCols = copyOf.matrixCols;
         matrixRows = copyOf.matrixRows;
@@ -1251,7 +1269,7 @@ public:
     // Recursively make temporary
     void makeTemporary()
     {
-        getQualifier().makeTemporary();
+        editQualifier([](TQualifier& q) { q.makeTemporary(); });
 
         if (isStruct())
             for (unsigned int i = 0; i < structure->size(); ++i)
@@ -1266,8 +1284,24 @@ public:
         return newType;
     }
 
+    // Flatten to, or rebuild from, the binary form used for caching built-in symbol tables.
+    void serialize(TSymbolWriter&) const;
+    bool deserialize(TSymbolReader&);
+
     void makeVector() { vector1 = true; }
 
+    // Give this type, and those it contains, their own qualifiers, for a type
+    // that is then shared read only, like a built-in's: reading one through a
+    // non-const type must not make a copy in another pool or thread.
+    void unshareQualifiers()
+    {
+        if (sharedQualifier)
+            copyQualifier();
+        if (isStruct())
+            for (unsigned int i = 0; i < structure->size(); ++i)
+                (*structure)[i].type->unshareQualifiers();
+    }
+
     // Merge type from parent, where a parentType is at the beginning of a declaration,
     // establishing some characteristics for all subsequent names, while this type
     // is on the individual names.
@@ -1279,7 +1313,7 @@ public:
         matrixCols = parentType.matrixCols;
         matrixRows = parentType.matrixRows;
         vector1 = false;                      // TPublicType is only GLSL which so far has no vec1
-        qualifier = parentType.qualifier;
+        shareQualifier(InternQualifier(parentType.qualifier));
         sampler = parentType.sampler;
         if (parentType.arraySizes)
             newArraySizes(*parentType.arraySizes);
@@ -1289,56 +1323,74 @@ public:
         }
     }
 
-    virtual void hideMember() { basicType = EbtVoid; vectorSize = 1; }
-    virtual bool hiddenMember() const { return basicType == EbtVoid; }
+    void hideMember() { basicType = EbtVoid; vectorSize = 1; }
+    bool hiddenMember() const { return basicType == EbtVoid; }
 
-    virtual void setTypeName(const TString& n) { typeName = NewPoolTString(n.c_str()); }
-    virtual void setFieldName(const TString& n) { fieldName = NewPoolTString(n.c_str()); }
-    virtual const TString& getTypeName() const
+    void setTypeName(const TString& n) { typeName = NewPoolTString(n.c_str()); }
+    void setFieldName(const TString& n) { fieldName = NewPoolTString(n.c_str()); }
+    const TString& getTypeName() const
     {
         assert(typeName);
         return *typeName;
     }
 
-    virtual const TString& getFieldName() const
+    const TString& getFieldName() const
     {
         assert(fieldName);
         return *fieldName;
     }
 
-    virtual TBasicType getBasicType() const { return basicType; }
-    virtual const TSampler& getSampler() const { return sampler; }
-    virtual TSampler& getSampler() { return sampler; }
-
-    virtual       TQualifier& getQualifier()       { return qualifier; }
-    virtual const TQualifier& getQualifier() const { return qualifier; }
-
-    virtual int getVectorSize() const { return vectorSize; }  // returns 1 for either scalar or vector of size 1, valid for both
-    virtual int getMatrixCols() const { return matrixCols; }
-    virtual int getMatrixRows() const { return matrixRows; }
-    virtual int getOuterArraySize()  const { return arraySizes->getOuterSize(); }
-    virtual TIntermTyped*  getOuterArrayNode() const { return arraySizes->getOuterNode(); }
-    virtual int getCumulativeArraySize()  const { return arraySizes->getCumulativeSize(); }
-    virtual bool isArrayOfArrays() const { return arraySizes != nullptr && arraySizes->getNumDims() > 1; }
-    virtual int getImplicitArraySize() const { return arraySizes->getImplicitSize(); }
-    virtual const TArraySizes* getArraySizes() const { return arraySizes; }
-    virtual       TArraySizes& getArraySizes()       { assert(arraySizes != nullptr); return *arraySizes; }
-
-    virtual bool isScalar() const { return ! isVector() && ! isMatrix() && ! isStruct() && ! isArray(); }
-    virtual bool isScalarOrVec1() const { return isScalar() || vector1; }
-    virtual bool isVector() const { return vectorSize > 1 || vector1; }
-    virtual bool isMatrix() const { return matrixCols ? true : false; }
-    virtual bool isArray()  const { return arraySizes != nullptr; }
-    virtual bool isExplicitlySizedArray() const { return isArray() && getOuterArraySize() != UnsizedArraySize; }
-    virtual bool isImplicitlySizedArray() const { return isArray() && getOuterArraySize() == UnsizedArraySize && qualifier.storage != EvqBuffer; }
-    virtual bool isRuntimeSizedArray()    const { return isArray() && getOuterArraySize() == UnsizedArraySize && qualifier.storage == EvqBuffer; }
-    virtual bool isStruct() const { return structure != nullptr; }
+    TBasicType getBasicType() const { return basicType; }
+    const TSampler& getSampler() const { return sampler; }
+    TSampler& getSampler() { return sampler; }
+
+          TQualifier& getQualifier()
+    {
+        if (sharedQualifier)
+            copyQualifier();
+        return *const_cast<TQualifier*>(qualifier);
+    }
+    const TQualifier& getQualifier() const { return *qualifier; }
+
+    // Change the qualifier without taking a copy of a shared one, as
+    // getQualifier() would; the result is shared in turn.
+    void setQualifier(const TQualifier& q) { shareQualifier(InternQualifier(q)); }
+    template<class Edit> void editQualifier(Edit edit)
+    {
+        if (sharedQualifier) {
+            TQualifier edited = *qualifier;
+            edit(edited);
+            setQualifier(edited);
+        } else
+            edit(*const_cast<TQualifier*>(qualifier));
+    }
+
+    int getVectorSize() const { return vectorSize; }  // returns 1 for either scalar or vector of size 1, valid for both
+    int getMatrixCols() const { return matrixCols; }
+    int getMatrixRows() const { return matrixRows; }
+    int getOuterArraySize()  const { return arraySizes->getOuterSize(); }
+    TIntermTyped*  getOuterArrayNode() const { return arraySizes->getOuterNode(); }
+    int getCumulativeArraySize()  const { return arraySizes->getCumulativeSize(); }
+    bool isArrayOfArrays() const { return arraySizes != nullptr && arraySizes->getNumDims() > 1; }
+    int getImplicitArraySize() const { return arraySizes->getImplicitSize(); }
+    const TArraySizes* getArraySizes() const { return arraySizes; }
+          TArraySizes& getArraySizes()       { assert(arraySizes != nullptr); return *arraySizes; }
+
+    bool isScalar() const { return ! isVector() && ! isMatrix() && ! isStruct() && ! isArray(); }
+    bool isScalarOrVec1() const { return isScalar() || vector1; }
+    bool isVector() const { return vectorSize > 1 || vector1; }
+    bool isMatrix() const { return matrixCols ? true : false; }
+    bool isArray()  const { return arraySizes != nullptr; }
+    bool isExplicitlySizedArray() const { return isArray() && getOuterArraySize() != UnsizedArraySize; }
+    bool isImplicitlySizedArray() const { return isArray() && getOuterArraySize() == UnsizedArraySize && qualifier->storage != EvqBuffer; }
+    bool isRuntimeSizedArray()    const { return isArray() && getOuterArraySize() == UnsizedArraySize && qualifier->storage == EvqBuffer; }
+    bool isStruct() const { return structure != nullptr; }
 #ifdef AMD_EXTENSIONS
-    virtual bool isFloatingDomain() const { return basicType == EbtFloat || basicType == EbtDouble || basicType == EbtFloat16; }
+    bool isFloatingDomain() const { return basicType == EbtFloat || basicType == EbtDouble || basicType == EbtFloat16; }
 #else
-    virtual bool isFloatingDomain() const { return basicType == EbtFloat || basicType == EbtDouble; }
+    bool isFloatingDomain() const { return basicType == EbtFloat || basicType == EbtDouble; }
 #endif
-    virtual bool isIntegerDomain() const
+    bool isIntegerDomain() const
     {
         switch (basicType) {
         case EbtInt:
@@ -1356,19 +1408,19 @@ public:
         }
         return false;
     }
-    virtual bool isOpaque() const { return basicType == EbtSampler || basicType == EbtAtomicUint; }
+    bool isOpaque() const { return basicType == EbtSampler || basicType == EbtAtomicUint; }
 
     // "Image" is a superset of "Subpass"
-    virtual bool isImage() const   { return basicType == EbtSampler && getSampler().isImage(); }
-    virtual bool isSubpass() const { return basicType == EbtSampler && getSampler().isSubpass(); }
+    bool isImage() const   { return basicType == EbtSampler && getSampler().isImage(); }
+    bool isSubpass() const { return basicType == EbtSampler && getSampler().isSubpass(); }
 
-    virtual bool isBuiltInInterstageIO(EShLanguage language) const
+    bool isBuiltInInterstageIO(EShLanguage language) const
     {
         return isPerVertexAndBuiltIn(language) || isLooseAndBuiltIn(language);
     }
 
     // Return true if this is an interstage IO builtin
-    virtual bool isPerVertexAndBuiltIn(EShLanguage language) const
+    bool isPerVertexAndBuiltIn(EShLanguage language) const
     {
         if (language == EShLangFragment)
             return false;
@@ -1394,7 +1446,7 @@ public:
     }
 
     // Return true if this is a loose builtin
-    virtual bool isLooseAndBuiltIn(EShLanguage language) const
+    bool isLooseAndBuiltIn(EShLanguage language) const
     {
         if (getQualifier().builtIn == EbvNone)
             return false;
@@ -1415,41 +1467,41 @@ public:
     }
 
     // Recursively checks if the type contains the given basic type
-    virtual bool containsBasicType(TBasicType checkType) const
+    bool containsBasicType(TBasicType checkType) const
     {
         return contains([checkType](const TType* t) { return t->basicType == checkType; } );
     }
 
     // Recursively check the structure for any arrays, needed for some error checks
-    virtual bool containsArray() const
+    bool containsArray() const
     {
         return contains([](const TType* t) { return t->isArray(); } );
     }
 
     // Check the structure for any structures, needed for some error checks
-    virtual bool containsStructure() const
+    bool containsStructure() const
     {
         return contains([this](const TType* t) { return t != this && t->isStruct(); } );
     }
 
     // Recursively check the structure for any implicitly-sized arrays, needed for triggering a copyUp().
-    virtual bool containsImplicitlySizedArray() const
+    bool containsImplicitlySizedArray() const
     {
         return contains([](const TType* t) { return t->isImplicitlySizedArray(); } );
     }
 
-    virtual bool containsOpaque() const
+    bool containsOpaque() const
     {
         return contains([](const TType* t) { return t->isOpaque(); } );
     }
 
     // Recursively checks if the type contains an interstage IO builtin
-    virtual bool containsBuiltInInterstageIO(EShLanguage language) const
+    bool containsBuiltInInterstageIO(EShLanguage language) const
     {
         return contains([language](const TType* t) { return t->isBuiltInInterstageIO(language); } );
     }
 
-    virtual bool containsNonOpaque() const
+    bool containsNonOpaque() const
     {
         const auto nonOpaque = [](const TType* t) {
             switch (t->basicType) {
@@ -1477,7 +1529,7 @@ public:
         return contains(nonOpaque);
     }
 
-    virtual bool containsSpecializationSize() const
+    bool containsSpecializationSize() const
     {
         return contains([](const TType* t) { return t->isArray() && t->arraySizes->isOuterSpecialization(); } );
     }
@@ -1571,88 +1623,88 @@ public:
         const auto appendUint = [&](unsigned int u) { typeString.append(std::to_string(u).c_str()); };
         const auto appendInt  = [&](int i)          { typeString.append(std::to_string(i).c_str()); };
 
-        if (qualifier.hasLayout()) {
+        if (qualifier->hasLayout()) {
             // To reduce noise, skip this if the only layout is an xfb_buffer
             // with no triggering xfb_offset.
-            TQualifier noXfbBuffer = qualifier;
+            TQualifier noXfbBuffer = *qualifier;
             noXfbBuffer.layoutXfbBuffer = TQualifier::layoutXfbBufferEnd;
             if (noXfbBuffer.hasLayout()) {
                 appendStr("layout(");
-                if (qualifier.hasAnyLocation()) {
+                if (qualifier->hasAnyLocation()) {
                     appendStr(" location=");
-                    appendUint(qualifier.layoutLocation);
-                    if (qualifier.hasComponent()) {
+                    appendUint(qualifier->layoutLocation);
+                    if (qualifier->hasComponent()) {
                         appendStr(" component=");
-                        appendUint(qualifier.layoutComponent);
+                        appendUint(qualifier->layoutComponent);
                     }
-                    if (qualifier.hasIndex()) {
+                    if (qualifier->hasIndex()) {
                         appendStr(" index=");
-                        appendUint(qualifier.layoutIndex);
+                        appendUint(qualifier->layoutIndex);
                     }
                 }
-                if (qualifier.hasSet()) {
+                if (qualifier->hasSet()) {
                     appendStr(" set=");
-                    appendUint(qualifier.layoutSet);
+                    appendUint(qualifier->layoutSet);
                 }
-                if (qualifier.hasBinding()) {
+                if (qualifier->hasBinding()) {
                     appendStr(" binding=");
-                    appendUint(qualifier.layoutBinding);
+                    appendUint(qualifier->layoutBinding);
                 }
-                if (qualifier.hasStream()) {
+                if (qualifier->hasStream()) {
                     appendStr(" stream=");
-                    appendUint(qualifier.layoutStream);
+                    appendUint(qualifier->layoutStream);
                 }
-                if (qualifier.hasMatrix()) {
+                if (qualifier->hasMatrix()) {
                     appendStr(" ");
-                    appendStr(TQualifier::getLayoutMatrixString(qualifier.layoutMatrix));
+                    appendStr(TQualifier::getLayoutMatrixString(qualifier->layoutMatrix));
                 }
-                if (qualifier.hasPacking()) {
+                if (qualifier->hasPacking()) {
                     appendStr(" ");
-                    appendStr(TQualifier::getLayoutPackingString(qualifier.layoutPacking));
+                    appendStr(TQualifier::getLayoutPackingString(qualifier->layoutPacking));
                 }
-                if (qualifier.hasOffset()) {
+                if (qualifier->hasOffset()) {
                     appendStr(" offset=");
-                    appendInt(qualifier.layoutOffset);
+                    appendInt(qualifier->layoutOffset);
                 }
-                if (qualifier.hasAlign()) {
+                if (qualifier->hasAlign()) {
                     appendStr(" align=");
-                    appendInt(qualifier.layoutAlign);
+                    appendInt(qualifier->layoutAlign);
                 }
-                if (qualifier.hasFormat()) {
+                if (qualifier->hasFormat()) {
                     appendStr(" ");
-                    appendStr(TQualifier::getLayoutFormatString(qualifier.layoutFormat));
+                    appendStr(TQualifier::getLayoutFormatString(qualifier->layoutFormat));
                 }
-                if (qualifier.hasXfbBuffer() && qualifier.hasXfbOffset()) {
+                if (qualifier->hasXfbBuffer() && qualifier->hasXfbOffset()) {
                     appendStr(" xfb_buffer=");
-                    appendUint(qualifier.layoutXfbBuffer);
+                    appendUint(qualifier->layoutXfbBuffer);
                 }
-                if (qualifier.hasXfbOffset()) {
+                if (qualifier->hasXfbOffset()) {
                     appendStr(" xfb_offset=");
-                    appendUint(qualifier.layoutXfbOffset);
+                    appendUint(qualifier->layoutXfbOffset);
                 }
-                if (qualifier.hasXfbStride()) {
+                if (qualifier->hasXfbStride()) {
                     appendStr(" xfb_stride=");
-                    appendUint(qualifier.layoutXfbStride);
+                    appendUint(qualifier->layoutXfbStride);
                 }
-                if (qualifier.hasAttachment()) {
+                if (qualifier->hasAttachment()) {
                     appendStr(" input_attachment_index=");
-                    appendUint(qualifier.layoutAttachment);
+                    appendUint(qualifier->layoutAttachment);
                 }
-                if (qualifier.hasSpecConstantId()) {
+                if (qualifier->hasSpecConstantId()) {
                     appendStr(" constant_id=");
-                    appendUint(qualifier.layoutSpecConstantId);
+                    appendUint(qualifier->layoutSpecConstantId);
                 }
-                if (qualifier.layoutPushConstant)
+                if (qualifier->layoutPushConstant)
                     appendStr(" push_constant");
 
 #ifdef NV_EXTENSIONS
-                if (qualifier.layoutPassthrough)
+                if (qualifier->layoutPassthrough)
                     appendStr(" passthrough");
-                if (qualifier.layoutViewportRelative)
+                if (qualifier->layoutViewportRelative)
                     appendStr(" layoutViewportRelative");
-                if (qualifier.layoutSecondaryViewportRelativeOffset != -2048) {
+                if (qualifier->layoutSecondaryViewportRelativeOffset != -2048) {
                     appendStr(" layoutSecondaryViewportRelativeOffset=");
-                    appendInt(qualifier.layoutSecondaryViewportRelativeOffset);
+                    appendInt(qualifier->layoutSecondaryViewportRelativeOffset);
                 }
 #endif
 
@@ -1660,37 +1712,37 @@ public:
             }
         }
 
-        if (qualifier.invariant)
+        if (qualifier->invariant)
             appendStr(" invariant");
-        if (qualifier.noContraction)
+        if (qualifier->noContraction)
             appendStr(" noContraction");
-        if (qualifier.centroid)
+        if (qualifier->centroid)
             appendStr(" centroid");
-        if (qualifier.smooth)
+        if (qualifier->smooth)
             appendStr(" smooth");
-        if (qualifier.flat)
+        if (qualifier->flat)
             appendStr(" flat");
-        if (qualifier.nopersp)
+        if (qualifier->nopersp)
             appendStr(" noperspective");
 #ifdef AMD_EXTENSIONS
-        if (qualifier.explicitInterp)
+        if (qualifier->explicitInterp)
             appendStr(" __explicitInterpAMD");
 #endif
-        if (qualifier.patch)
+        if (qualifier->patch)
             appendStr(" patch");
-        if (qualifier.sample)
+        if (qualifier->sample)
             appendStr(" sample");
-        if (qualifier.coherent)
+        if (qualifier->coherent)
             appendStr(" coherent");
-        if (qualifier.volatil)
+        if (qualifier->volatil)
             appendStr(" volatile");
-        if (qualifier.restrict)
+        if (qualifier->restrict)
             appendStr(" restrict");
-        if (qualifier.readonly)
+        if (qualifier->readonly)
             appendStr(" readonly");
-        if (qualifier.writeonly)
+        if (qualifier->writeonly)
             appendStr(" writeonly");
-        if (qualifier.specConstant)
+        if (qualifier->specConstant)
             appendStr(" specialization-constant");
         appendStr(" ");
         appendStr(getStorageQualifierString());
@@ -1706,7 +1758,7 @@ public:
                 }
             }
         }
-        if (qualifier.precision != EpqNone) {
+        if (qualifier->precision != EpqNone) {
             appendStr(" ");
             appendStr(getPrecisionQualifierString());
         }
@@ -1725,7 +1777,7 @@ public:
         appendStr(" ");
         typeString.append(getBasicTypeString());
 
-        if (qualifier.builtIn != EbvNone) {
+        if (qualifier->builtIn != EbvNone) {
             appendStr(" ");
             appendStr(getBuiltInVariableString());
         }
@@ -1756,9 +1808,9 @@ public:
             return getBasicString();
     }
 
-    const char* getStorageQualifierString() const { return GetStorageQualifierString(qualifier.storage); }
-    const char* getBuiltInVariableString() const { return GetBuiltInVariableString(qualifier.builtIn); }
-    const char* getPrecisionQualifierString() const { return GetPrecisionQualifierString(qualifier.precision); }
+    const char* getStorageQualifierString() const { return GetStorageQualifierString(qualifier->storage); }
+    const char* getBuiltInVariableString() const { return GetBuiltInVariableString(qualifier->builtIn); }
+    const char* getPrecisionQualifierString() const { return GetPrecisionQualifierString(qualifier->precision); }
     const TTypeList* getStruct() const { return structure; }
     void setStruct(TTypeList* s) { structure = s; }
     TTypeList* getWritableStruct() const { return structure; }  // This should only be used when known to not be sharing with other threads
@@ -1877,6 +1929,7 @@ protected:
     void deepCopy(const TType& copyOf, TMap<TTypeList*,TTypeList*>& copiedMap)
     {
         shallowCopy(copyOf);
+        shareQualifier(InternQualifier(*copyOf.qualifier));
 
         if (copyOf.arraySizes) {
             arraySizes = new TArraySizes;
@@ -1909,6 +1962,20 @@ protected:
 
     void buildMangledName(TString&) const;
 
+    void shareQualifier(const TQualifier* q)
+    {
+        qualifier = q;
+        sharedQualifier = true;
+    }
+
+    // Give this type its own copy of its qualifier, to write to.
+    void copyQualifier()
+    {
+        void* memory = GetThreadPoolAllocator().allocate(sizeof(TQualifier));
+        qualifier = new(memory) TQualifier(*qualifier);
+        sharedQualifier = false;
+    }
+
     TBasicType basicType : 8;
     int vectorSize       : 4;  // 1 means either scalar or 1-component vector; see vector1 to disambiguate.
     int matrixCols       : 4;
@@ -1918,13 +1985,14 @@ protected:
                                // functionality is added.
                                // HLSL does have a 1-component vectors, so this will be true to disambiguate
                                // from a scalar.
-    TQualifier qualifier;
+    bool sharedQualifier : 1;  // qualifier is shared, and is copied before being written
+    TSampler sampler;           // here, to share the word with the above
+    const TQualifier* qualifier;  // never nullptr
 
     TArraySizes* arraySizes;    // nullptr unless an array; can be shared across types
     TTypeList* structure;       // nullptr unless this is a struct; can be shared across types
     TString *fieldName;         // for structure field names
     TString *typeName;          // for structure type name
-    TSampler sampler;
 };
 
 } // end namespace glslang
@@ -843,7 +843,6 @@ public:
     virtual TType& getWritableType() { return type; }
 
     virtual TBasicType getBasicType() const { return type.getBasicType(); }
-    virtual TQualifier& getQualifier() { return type.getQualifier(); }
     virtual const TQualifier& getQualifier() const { return type.getQualifier(); }
     virtual void propagatePrecision(TPrecisionQualifier);
     virtual int getVectorSize() const { return type.getVectorSize(); }
@@ -967,6 +966,7 @@ protected:
 class TIntermConstantUnion : public TIntermTyped {
 public:
     TIntermConstantUnion(const TConstUnionArray& ua, const TType& t) : TIntermTyped(t), constArray(ua), literal(false) { }
+    void setConstArray(const TConstUnionArray& c) { assert(c.identical(constArray)); constArray = c; }
     const TConstUnionArray& getConstArray() const { return constArray; }
     virtual       TIntermConstantUnion* getAsConstantUnion()       { return this; }
     virtual const TIntermConstantUnion* getAsConstantUnion() const { return this; }
@@ -980,7 +980,7 @@ public:
 protected:
     TIntermConstantUnion& operator=(const TIntermConstantUnion&);
 
-    const TConstUnionArray constArray;
+    TConstUnionArray constArray; // only ever replaced with equal contents, see setConstArray()
     bool literal;  // true if node represents a literal in the source code
 };
 
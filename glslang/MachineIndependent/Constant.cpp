@@ -966,7 +966,7 @@ TIntermTyped* TIntermediate::foldConstructor(TIntermAggregate* aggrNode)
     if (error)
         return aggrNode;
 
-    return addConstantUnion(unionArray, aggrNode->getType(), aggrNode->getLoc());
+    return addConstantUnion(internConstArray(unionArray), aggrNode->getType(), aggrNode->getLoc());
 }
 
 //
@@ -994,7 +994,8 @@ TIntermTyped* TIntermediate::foldDereference(TIntermTyped* node, int index, cons
             start += (*node->getType().getStruct())[i].type->computeNumComponents();
     }
 
-    result = addConstantUnion(TConstUnionArray(node->getAsConstantUnion()->getConstArray(), start, size), node->getType(), loc);
+    result = addConstantUnion(internConstArray(TConstUnionArray(node->getAsConstantUnion()->getConstArray(), start, size)),
+                              node->getType(), loc);
 
     if (result == 0)
         result = node;
@@ -1016,7 +1017,7 @@ TIntermTyped* TIntermediate::foldSwizzle(TIntermTyped* node, TSwizzleSelectors<T
     for (int i = 0; i < selectors.size(); i++)
         constArray[i] = unionArray[selectors[i]];
 
-    TIntermTyped* result = addConstantUnion(constArray, node->getType(), loc);
+    TIntermTyped* result = addConstantUnion(internConstArray(constArray), node->getType(), loc);
 
     if (result == 0)
         result = node;
@@ -151,7 +151,7 @@ TIntermTyped* TIntermediate::addBinaryMath(TOperator op, TIntermTyped* left, TIn
     TIntermConstantUnion *leftTempConstant = node->getLeft()->getAsConstantUnion();
     TIntermConstantUnion *rightTempConstant = node->getRight()->getAsConstantUnion();
     if (leftTempConstant && rightTempConstant) {
-        TIntermTyped* folded = leftTempConstant->fold(node->getOp(), rightTempConstant);
+        TIntermTyped* folded = internConstants(leftTempConstant->fold(node->getOp(), rightTempConstant));
         if (folded)
             return folded;
     }
@@ -159,7 +159,7 @@ TIntermTyped* TIntermediate::addBinaryMath(TOperator op, TIntermTyped* left, TIn
     // If can propagate spec-constantness and if the operation is an allowed
     // specialization-constant operation, make a spec-constant.
     if (specConstantPropagates(*node->getLeft(), *node->getRight()) && isSpecializationOperation(*node))
-        node->getWritableType().getQualifier().makeSpecConstant();
+        node->getWritableType().editQualifier([](TQualifier& q) { q.makeSpecConstant(); });
 
     return node;
 }
@@ -366,12 +366,12 @@ TIntermTyped* TIntermediate::addUnaryMath(TOperator op, TIntermTyped* child, TSo
 
     // If it's a (non-specialization) constant, it must be folded.
     if (node->getOperand()->getAsConstantUnion())
-        return node->getOperand()->getAsConstantUnion()->fold(op, node->getType());
+        return internConstants(node->getOperand()->getAsConstantUnion()->fold(op, node->getType()));
 
     // If it's a specialization constant, the result is too,
     // if the operation is allowed for specialization constants.
     if (node->getOperand()->getType().getQualifier().isSpecConstant() && isSpecializationOperation(*node))
-        node->getWritableType().getQualifier().makeSpecConstant();
+        node->getWritableType().editQualifier([](TQualifier& q) { q.makeSpecConstant(); });
 
     return node;
 }
@@ -389,7 +389,7 @@ TIntermTyped* TIntermediate::addBuiltInFunctionCall(const TSourceLoc& loc, TOper
             return nullptr;
 
         if (child->getAsConstantUnion()) {
-            TIntermTyped* folded = child->getAsConstantUnion()->fold(op, returnType);
+            TIntermTyped* folded = internConstants(child->getAsConstantUnion()->fold(op, returnType));
             if (folded)
                 return folded;
         }
@@ -869,7 +869,7 @@ TIntermTyped* TIntermediate::addConversion(TOperator op, const TType& type, TInt
 
     // Propagate specialization-constant-ness, if allowed
     if (node->getType().getQualifier().isSpecConstant() && isSpecializationOperation(*newNode))
-        newNode->getWritableType().getQualifier().makeSpecConstant();
+        newNode->getWritableType().editQualifier([](TQualifier& q) { q.makeSpecConstant(); });
 
     return newNode;
 }
@@ -1641,7 +1641,7 @@ TIntermTyped* TIntermediate::addComma(TIntermTyped* left, TIntermTyped* right, c
     TIntermTyped *commaAggregate = growAggregate(left, right, loc);
     commaAggregate->getAsAggregate()->setOperator(EOpComma);
     commaAggregate->setType(right->getType());
-    commaAggregate->getWritableType().getQualifier().makeTemporary();
+    commaAggregate->getWritableType().editQualifier([](TQualifier& q) { q.makeTemporary(); });
 
     return commaAggregate;
 }
@@ -1732,14 +1732,17 @@ TIntermTyped* TIntermediate::addSelection(TIntermTyped* cond, TIntermTyped* true
     //
     TIntermSelection* node = new TIntermSelection(cond, trueBlock, falseBlock, trueBlock->getType());
     node->setLoc(loc);
-    node->getQualifier().precision = std::max(trueBlock->getQualifier().precision, falseBlock->getQualifier().precision);
-
-    if ((cond->getQualifier().isConstant() && specConstantPropagates(*trueBlock, *falseBlock)) ||
-        (cond->getQualifier().isSpecConstant() && trueBlock->getQualifier().isConstant() &&
-                                                 falseBlock->getQualifier().isConstant()))
-        node->getQualifier().makeSpecConstant();
-    else
-        node->getQualifier().makeTemporary();
+    const TPrecisionQualifier precision = std::max(trueBlock->getQualifier().precision, falseBlock->getQualifier().precision);
+    const bool specConstant = (cond->getQualifier().isConstant() && specConstantPropagates(*trueBlock, *falseBlock)) ||
+                              (cond->getQualifier().isSpecConstant() && trueBlock->getQualifier().isConstant() &&
+                                                                        falseBlock->getQualifier().isConstant());
+    node->getWritableType().editQualifier([precision, specConstant](TQualifier& q) {
+        q.precision = precision;
+        if (specConstant)
+            q.makeSpecConstant();
+        else
+            q.makeTemporary();
+    });
 
     return node;
 }
@@ -1753,7 +1756,7 @@ TIntermTyped* TIntermediate::addSelection(TIntermTyped* cond, TIntermTyped* true
 TIntermConstantUnion* TIntermediate::addConstantUnion(const TConstUnionArray& unionArray, const TType& t, const TSourceLoc& loc, bool literal) const
 {
     TIntermConstantUnion* node = new TIntermConstantUnion(unionArray, t);
-    node->getQualifier().storage = EvqConst;
+    node->getWritableType().editQualifier([](TQualifier& q) { q.storage = EvqConst; });
     node->setLoc(loc);
     if (literal)
         node->setLiteral();
@@ -1763,60 +1766,60 @@ TIntermConstantUnion* TIntermediate::addConstantUnion(const TConstUnionArray& un
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(int i, const TSourceLoc& loc, bool literal) const
 {
-    TConstUnionArray unionArray(1);
-    unionArray[0].setIConst(i);
+    TConstUnion value;
+    value.setIConst(i);
 
-    return addConstantUnion(unionArray, TType(EbtInt, EvqConst), loc, literal);
+    return addConstantUnion(internConstant(value), TType(EbtInt, EvqConst), loc, literal);
 }
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(unsigned int u, const TSourceLoc& loc, bool literal) const
 {
-    TConstUnionArray unionArray(1);
-    unionArray[0].setUConst(u);
+    TConstUnion value;
+    value.setUConst(u);
 
-    return addConstantUnion(unionArray, TType(EbtUint, EvqConst), loc, literal);
+    return addConstantUnion(internConstant(value), TType(EbtUint, EvqConst), loc, literal);
 }
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(long long i64, const TSourceLoc& loc, bool literal) const
 {
-    TConstUnionArray unionArray(1);
-    unionArray[0].setI64Const(i64);
+    TConstUnion value;
+    value.setI64Const(i64);
 
-    return addConstantUnion(unionArray, TType(EbtInt64, EvqConst), loc, literal);
+    return addConstantUnion(internConstant(value), TType(EbtInt64, EvqConst), loc, literal);
 }
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(unsigned long long u64, const TSourceLoc& loc, bool literal) const
 {
-    TConstUnionArray unionArray(1);
-    unionArray[0].setU64Const(u64);
+    TConstUnion value;
+    value.setU64Const(u64);
 
-    return addConstantUnion(unionArray, TType(EbtUint64, EvqConst), loc, literal);
+    return addConstantUnion(internConstant(value), TType(EbtUint64, EvqConst), loc, literal);
 }
 
 #ifdef AMD_EXTENSIONS
 TIntermConstantUnion* TIntermediate::addConstantUnion(short i16, const TSourceLoc& loc, bool literal) const
 {
-    TConstUnionArray unionArray(1);
-    unionArray[0].setIConst(i16);
+    TConstUnion value;
+    value.setIConst(i16);
 
-    return addConstantUnion(unionArray, TType(EbtInt16, EvqConst), loc, literal);
+    return addConstantUnion(internConstant(value), TType(EbtInt16, EvqConst), loc, literal);
 }
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(unsigned short u16, const TSourceLoc& loc, bool literal) const
 {
-    TConstUnionArray unionArray(1);
-    unionArray[0].setUConst(u16);
+    TConstUnion value;
+    value.setUConst(u16);
 
-    return addConstantUnion(unionArray, TType(EbtUint16, EvqConst), loc, literal);
+    return addConstantUnion(internConstant(value), TType(EbtUint16, EvqConst), loc, literal);
 }
 #endif
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(bool b, const TSourceLoc& loc, bool literal) const
 {
-    TConstUnionArray unionArray(1);
-    unionArray[0].setBConst(b);
+    TConstUnion value;
+    value.setBConst(b);
 
-    return addConstantUnion(unionArray, TType(EbtBool, EvqConst), loc, literal);
+    return addConstantUnion(internConstant(value), TType(EbtBool, EvqConst), loc, literal);
 }
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(double d, TBasicType baseType, const TSourceLoc& loc, bool literal) const
@@ -1827,10 +1830,10 @@ TIntermConstantUnion* TIntermediate::addConstantUnion(double d, TBasicType baseT
     assert(baseType == EbtFloat || baseType == EbtDouble);
 #endif
 
-    TConstUnionArray unionArray(1);
-    unionArray[0].setDConst(d);
+    TConstUnion value;
+    value.setDConst(d);
 
-    return addConstantUnion(unionArray, TType(baseType, EvqConst), loc, literal);
+    return addConstantUnion(internConstant(value), TType(baseType, EvqConst), loc, literal);
 }
 
 TIntermConstantUnion* TIntermediate::addConstantUnion(const TString* s, const TSourceLoc& loc, bool literal) const
@@ -1841,6 +1844,55 @@ TIntermConstantUnion* TIntermediate::addConstantUnion(const TString* s, const TS
     return addConstantUnion(unionArray, TType(EbtString, EvqConst), loc, literal);
 }
 
+//
+// Constants made by literals and folding are interned per compile, so that
+// identical ones share one TConstUnionArray's storage, and comparing them is
+// a pointer compare.  Identical means bit-for-bit, so 0.0 and -0.0 stay apart.
+//
+// Only pass arrays that are not written after creation.  That rules out
+// the constant values of variables, see TVariable::getWritableConstArray().
+//
+TConstUnionArray TIntermediate::internConstArray(const TConstUnionArray& unionArray) const
+{
+    if (unionArray.empty())
+        return unionArray;
+
+    const size_t hash = unionArray.hash();
+    const auto range = constArrays.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.identical(unionArray))
+            return it->second;
+    }
+    constArrays.insert(std::make_pair(hash, unionArray));
+
+    return unionArray;
+}
+
+// Same as above, for a scalar, but without making an array when
+// there already is one.
+TConstUnionArray TIntermediate::internConstant(const TConstUnion& value) const
+{
+    const size_t hash = TConstUnionArray::hash(TConstUnionArray().hash(), value);
+    const auto range = constArrays.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.size() == 1 && it->second[0].identical(value))
+            return it->second;
+    }
+    TConstUnionArray unionArray(1, value);
+    constArrays.insert(std::make_pair(hash, unionArray));
+
+    return unionArray;
+}
+
+// Intern the array of a node just made by folding, if it is a constant.
+TIntermTyped* TIntermediate::internConstants(TIntermTyped* node) const
+{
+    if (node != nullptr && node->getAsConstantUnion() != nullptr)
+        node->getAsConstantUnion()->setConstArray(internConstArray(node->getAsConstantUnion()->getConstArray()));
+
+    return node;
+}
+
 // Put vector swizzle selectors onto the given sequence
 void TIntermediate::pushSelector(TIntermSequence& sequence, const TVectorSelector& selector, const TSourceLoc& loc)
 {
@@ -2360,7 +2412,7 @@ bool TIntermediate::promoteUnary(TIntermUnary& node)
     }
 
     node.setType(operand->getType());
-    node.getWritableType().getQualifier().makeTemporary();
+    node.getWritableType().editQualifier([](TQualifier& q) { q.makeTemporary(); });
 
     return true;
 }
@@ -2372,8 +2424,9 @@ void TIntermUnary::updatePrecision()
 #else
     if (getBasicType() == EbtInt || getBasicType() == EbtUint || getBasicType() == EbtFloat) {
 #endif
-        if (operand->getQualifier().precision > getQualifier().precision)
-            getQualifier().precision = operand->getQualifier().precision;
+        const TPrecisionQualifier precision = operand->getQualifier().precision;
+        if (precision > getQualifier().precision)
+            type.editQualifier([precision](TQualifier& q) { q.precision = precision; });
     }
 }
 
@@ -2753,7 +2806,7 @@ bool TIntermediate::promoteBinary(TIntermBinary& node)
             return false;
         if (right->isVector() || right->isMatrix()) {
             node.getWritableType().shallowCopy(right->getType());
-            node.getWritableType().getQualifier().makeTemporary();
+            node.getWritableType().editQualifier([](TQualifier& q) { q.makeTemporary(); });
         }
         break;
 
@@ -2864,10 +2917,12 @@ void TIntermBinary::updatePrecision()
 #else
     if (getBasicType() == EbtInt || getBasicType() == EbtUint || getBasicType() == EbtFloat) {
 #endif
-        getQualifier().precision = std::max(right->getQualifier().precision, left->getQualifier().precision);
-        if (getQualifier().precision != EpqNone) {
-            left->propagatePrecision(getQualifier().precision);
-            right->propagatePrecision(getQualifier().precision);
+        const TPrecisionQualifier precision = std::max(right->getQualifier().precision, left->getQualifier().precision);
+        if (precision != getQualifier().precision)
+            type.editQualifier([precision](TQualifier& q) { q.precision = precision; });
+        if (precision != EpqNone) {
+            left->propagatePrecision(precision);
+            right->propagatePrecision(precision);
         }
     }
 }
@@ -2881,7 +2936,7 @@ void TIntermTyped::propagatePrecision(TPrecisionQualifier newPrecision)
 #endif
         return;
 
-    getQualifier().precision = newPrecision;
+    type.editQualifier([newPrecision](TQualifier& q) { q.precision = newPrecision; });
 
     TIntermBinary* binaryNode = getAsBinaryNode();
     if (binaryNode) {
@@ -2930,6 +2985,16 @@ TIntermTyped* TIntermediate::promoteConstantUnion(TBasicType promoteTo, TIntermC
     const TConstUnionArray& rightUnionArray = node->getConstArray();
     int size = node->getType().computeNumComponents();
 
+    // All floating-point types keep their components as doubles, so converting
+    // between them leaves every component as it is: share the array instead
+    // of copying it component by component.
+    if (node->getType().isFloatingDomain()) {
+        const TType& t = node->getType();
+        TType promoted(promoteTo, t.getQualifier().storage, t.getVectorSize(), t.getMatrixCols(), t.getMatrixRows());
+        if (promoted.isFloatingDomain())
+            return addConstantUnion(rightUnionArray, promoted, node->getLoc());
+    }
+
     TConstUnionArray leftUnionArray(size);
 
     for (int i=0; i < size; i++) {
@@ -3165,7 +3230,7 @@ TIntermTyped* TIntermediate::promoteConstantUnion(TBasicType promoteTo, TIntermC
 
     const TType& t = node->getType();
 
-    return addConstantUnion(leftUnionArray, TType(promoteTo, t.getQualifier().storage, t.getVectorSize(), t.getMatrixCols(), t.getMatrixRows()),
+    return addConstantUnion(internConstArray(leftUnionArray), TType(promoteTo, t.getQualifier().storage, t.getVectorSize(), t.getMatrixCols(), t.getMatrixRows()),
                             node->getLoc());
 }
 
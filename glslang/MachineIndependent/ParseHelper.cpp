@@ -717,7 +717,7 @@ TIntermTyped* TParseContext::handleDotDereference(const TSourceLoc& loc, TInterm
             }
             // Swizzle operations propagate specialization-constantness
             if (base->getType().getQualifier().isSpecConstant())
-                result->getWritableType().getQualifier().makeSpecConstant();
+                result->getWritableType().editQualifier([](TQualifier& q) { q.makeSpecConstant(); });
         }
     } else if (base->getBasicType() == EbtStruct || base->getBasicType() == EbtBlock) {
         const TTypeList* fields = base->getType().getStruct();
@@ -978,7 +978,7 @@ TIntermTyped* TParseContext::handleFunctionCall(const TSourceLoc& loc, TFunction
                         if (lValueErrorCheck(arguments->getLoc(), "assign", arg->getAsTyped()))
                             error(arguments->getLoc(), "Non-L-value cannot be passed for 'out' or 'inout' parameters.", "out", "");
                     }
-                    TQualifier& argQualifier = arg->getAsTyped()->getQualifier();
+                    const TQualifier& argQualifier = arg->getAsTyped()->getQualifier();
                     if (argQualifier.isMemory()) {
                         const char* message = "argument cannot drop memory qualifier when passed to formal parameter";
                         if (argQualifier.volatil && ! formalQualifier.volatil)
@@ -1153,13 +1153,13 @@ void TParseContext::computeBuiltinPrecisions(TIntermTyped& node, const TFunction
 
     // Propagate precision through this node and its children. That algorithm stops
     // when a precision is found, so start by clearing this subroot precision
-    opNode->getQualifier().precision = EpqNone;
+    opNode->getWritableType().editQualifier([](TQualifier& q) { q.precision = EpqNone; });
     if (operationPrecision != EpqNone) {
         opNode->propagatePrecision(operationPrecision);
         opNode->setOperationPrecision(operationPrecision);
     }
     // Now, set the result precision, which might not match
-    opNode->getQualifier().precision = resultPrecision;
+    opNode->getWritableType().editQualifier([resultPrecision](TQualifier& q) { q.precision = resultPrecision; });
 }
 
 TIntermNode* TParseContext::handleReturnValue(const TSourceLoc& loc, TIntermTyped* value)
@@ -1342,7 +1342,7 @@ TIntermTyped* TParseContext::addOutputArgumentConversions(const TFunction& funct
                 // Out-qualified arguments need to use the topology set up above.
                 // do the " ...(tempArg, ...), arg = tempArg" bit from above
                 TVariable* tempArg = makeInternalVariable("tempArg", *function[i].type);
-                tempArg->getWritableType().getQualifier().makeTemporary();
+                tempArg->getWritableType().editQualifier([](TQualifier& q) { q.makeTemporary(); });
                 TIntermSymbol* tempArgNode = intermediate.addSymbol(*tempArg, intermNode.getLoc());
                 TIntermTyped* tempAssign = intermediate.addAssign(EOpAssign, arguments[i]->getAsTyped(), tempArgNode, arguments[i]->getLoc());
                 conversionTree = intermediate.growAggregate(conversionTree, tempAssign, arguments[i]->getLoc());
@@ -1614,8 +1614,10 @@ void TParseContext::nonOpBuiltInCheck(const TSourceLoc& loc, const TFunction& fn
 
     // built-in texturing functions get their return value precision from the precision of the sampler
     if (fnCandidate.getType().getQualifier().precision == EpqNone &&
-        fnCandidate.getParamCount() > 0 && fnCandidate[0].type->getBasicType() == EbtSampler)
-        callNode.getQualifier().precision = callNode.getSequence()[0]->getAsTyped()->getQualifier().precision;
+        fnCandidate.getParamCount() > 0 && fnCandidate[0].type->getBasicType() == EbtSampler) {
+        const TPrecisionQualifier precision = callNode.getSequence()[0]->getAsTyped()->getQualifier().precision;
+        callNode.getWritableType().editQualifier([precision](TQualifier& q) { q.precision = precision; });
+    }
 
     if (fnCandidate.getName().compare(0, 7, "texture") == 0) {
         if (fnCandidate.getName().compare(0, 13, "textureGather") == 0) {
@@ -5240,7 +5242,7 @@ TIntermNode* TParseContext::executeInitializer(const TSourceLoc& loc, TIntermTyp
     if (! initializer) {
         // error recovery; don't leave const without constant values
         if (qualifier == EvqConst)
-            variable->getWritableType().getQualifier().makeTemporary();
+            variable->getWritableType().editQualifier([](TQualifier& q) { q.makeTemporary(); });
         return nullptr;
     }
 
@@ -5263,13 +5265,13 @@ TIntermNode* TParseContext::executeInitializer(const TSourceLoc& loc, TIntermTyp
     // Uniforms require a compile-time constant initializer
     if (qualifier == EvqUniform && ! initializer->getType().getQualifier().isFrontEndConstant()) {
         error(loc, "uniform initializers must be constant", "=", "'%s'", variable->getType().getCompleteString().c_str());
-        variable->getWritableType().getQualifier().makeTemporary();
+        variable->getWritableType().editQualifier([](TQualifier& q) { q.makeTemporary(); });
         return nullptr;
     }
     // Global consts require a constant initializer (specialization constant is okay)
     if (qualifier == EvqConst && symbolTable.atGlobalLevel() && ! initializer->getType().getQualifier().isConstant()) {
         error(loc, "global const initializers must be constant", "=", "'%s'", variable->getType().getCompleteString().c_str());
-        variable->getWritableType().getQualifier().makeTemporary();
+        variable->getWritableType().editQualifier([](TQualifier& q) { q.makeTemporary(); });
         return nullptr;
     }
 
@@ -5305,7 +5307,7 @@ TIntermNode* TParseContext::executeInitializer(const TSourceLoc& loc, TIntermTyp
         if (! initializer || ! initializer->getType().getQualifier().isConstant() || variable->getType() != initializer->getType()) {
             error(loc, "non-matching or non-convertible constant type for const initializer",
                   variable->getType().getStorageQualifierString(), "");
-            variable->getWritableType().getQualifier().makeTemporary();
+            variable->getWritableType().editQualifier([](TQualifier& q) { q.makeTemporary(); });
             return nullptr;
         }
 
@@ -5317,7 +5319,7 @@ TIntermNode* TParseContext::executeInitializer(const TSourceLoc& loc, TIntermTyp
             variable->setConstArray(initializer->getAsConstantUnion()->getConstArray());
         else {
             // It's a specialization constant.
-            variable->getWritableType().getQualifier().makeSpecConstant();
+            variable->getWritableType().editQualifier([](TQualifier& q) { q.makeSpecConstant(); });
 
             // Keep the subtree that computes the specialization constant with the variable.
             // Later, a symbol node will adopt the subtree from the variable.
@@ -6133,7 +6135,7 @@ void TParseContext::addQualifierToExisting(const TSourceLoc& loc, TQualifier qua
             error(loc, "cannot change qualification after use", "precise", "");
         symbol->getWritableType().getQualifier().noContraction = true;
     } else if (qualifier.specConstant) {
-        symbol->getWritableType().getQualifier().makeSpecConstant();
+        symbol->getWritableType().editQualifier([](TQualifier& q) { q.makeSpecConstant(); });
         if (qualifier.hasSpecConstantId())
             symbol->getWritableType().getQualifier().layoutSpecConstantId = qualifier.layoutSpecConstantId;
     } else
@@ -34,14 +34,23 @@
 
 #include "../Include/Common.h"
 #include "../Include/PoolAlloc.h"
+#include "../Public/ShaderLang.h"
 
 #include "../Include/InitializeGlobals.h"
 #include "../OSDependent/osinclude.h"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
 namespace glslang {
 
 OS_TLSIndex PoolIndex;
 
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+thread_local TPoolAllocator* ThreadPoolAllocator = nullptr;
+#endif
+
 void InitializeMemoryPools()
 {
     TThreadMemoryPools* pools = static_cast<TThreadMemoryPools*>(OS_GetTLSValue(PoolIndex));
@@ -55,6 +64,9 @@ void InitializeMemoryPools()
     threadData->threadPoolAllocator = threadPoolAllocator;
 
     OS_SetTLSValue(PoolIndex, threadData);
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+    ThreadPoolAllocator = threadPoolAllocator;
+#endif
 }
 
 void FreeGlobalPools()
@@ -67,6 +79,10 @@ void FreeGlobalPools()
     GetThreadPoolAllocator().popAll();
     delete &GetThreadPoolAllocator();
     delete globalPools;
+    OS_SetTLSValue(PoolIndex, nullptr);
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+    ThreadPoolAllocator = nullptr;
+#endif
 }
 
 bool InitializePoolIndex()
@@ -84,18 +100,219 @@ void FreePoolIndex()
     OS_FreeTLSIndex(PoolIndex);
 }
 
+#ifdef GLSLANG_OS_TLS_POOL_ALLOCATOR
 TPoolAllocator& GetThreadPoolAllocator()
 {
     TThreadMemoryPools* threadData = static_cast<TThreadMemoryPools*>(OS_GetTLSValue(PoolIndex));
 
     return *threadData->threadPoolAllocator;
 }
+#endif
 
 void SetThreadPoolAllocator(TPoolAllocator& poolAllocator)
 {
     TThreadMemoryPools* threadData = static_cast<TThreadMemoryPools*>(OS_GetTLSValue(PoolIndex));
 
     threadData->threadPoolAllocator = &poolAllocator;
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+    ThreadPoolAllocator = &poolAllocator;
+#endif
+}
+
+namespace {
+
+TPoolConfig PoolConfig;
+
+// The application's allocator, if it set one.
+TAllocatorCallbacks AllocatorCallbacks = { nullptr, nullptr, nullptr };
+
+// Bumped each time the allocator changes, so pages cached from an earlier one,
+// even by other threads, are given back instead of being handed out again.
+std::atomic<unsigned int> AllocatorGeneration(0);
+
+typedef void (*TFreeMemory)(void* userData, void* memory, size_t size);
+
+// A page not in use by any pool, and how to give it back.
+struct TCachedPage {
+    void* memory;
+    size_t size;
+    TFreeMemory freeMemory;
+    void* freeData;
+    unsigned int generation;  // of the allocator it came from
+};
+
+//
+// Multi-page allocations freed by any pool are kept here, up to
+// PoolConfig.largePageCacheSize bytes, for the next pool needing
+// one about the same size.
+//
+std::mutex LargePageMutex;
+std::vector<TCachedPage> LargePages;
+size_t LargePageBytes = 0;
+const size_t MaxLargePages = 32;
+
+// Blocks at least this big are mapped from the OS when asking for huge pages.
+const size_t HugePageSize = 2 * 1024 * 1024;
+
+void DeleteMemory(void*, void* memory, size_t)
+{
+    delete [] static_cast<char*>(memory);
+}
+
+void UnmapMemory(void*, void* memory, size_t size)
+{
+    OS_UnmapMemory(memory, size);
+}
+
+// Get page.size bytes for 'page', from the application if it gave an allocator,
+// else mapped from the OS if it's big and huge pages are asked for, else from new.
+void AllocatePageMemory(TCachedPage& page)
+{
+    page.generation = AllocatorGeneration;
+
+    if (AllocatorCallbacks.allocatePage) {
+        page.memory = AllocatorCallbacks.allocatePage(AllocatorCallbacks.userData, page.size);
+        page.freeMemory = AllocatorCallbacks.freePage;
+        page.freeData = AllocatorCallbacks.userData;
+        return;
+    }
+
+    if (PoolConfig.hugePages && page.size >= HugePageSize) {
+        page.memory = OS_MapMemory(page.size, true);
+        if (page.memory) {
+            page.freeMemory = UnmapMemory;
+            page.freeData = nullptr;
+            return;
+        }
+    }
+
+    page.memory = ::new char[page.size];
+    page.freeMemory = DeleteMemory;
+    page.freeData = nullptr;
+}
+
+void FreePageMemory(const TCachedPage& page)
+{
+    page.freeMemory(page.freeData, page.memory, page.size);
+}
+
+// Free cached pages until 'bytes' of them fit in 'limit'.
+void TrimPageCache(std::vector<TCachedPage>& pages, size_t& bytes, size_t limit)
+{
+    while (bytes > limit) {
+        bytes -= pages.back().size;
+        FreePageMemory(pages.back());
+        pages.pop_back();
+    }
+}
+
+// Take the smallest cached page of at least 'size' bytes, but not one bigger than 'maxSize'.
+// Pages from an earlier allocator are freed along the way.
+bool TakeCachedPage(std::vector<TCachedPage>& pages, size_t& bytes, size_t size, size_t maxSize,
+                    TCachedPage& taken)
+{
+    const unsigned int generation = AllocatorGeneration;
+    for (size_t p = 0; p < pages.size(); ) {
+        if (pages[p].generation != generation) {
+            bytes -= pages[p].size;
+            FreePageMemory(pages[p]);
+            pages[p] = pages.back();
+            pages.pop_back();
+        } else
+            ++p;
+    }
+
+    auto best = pages.end();
+    for (auto it = pages.begin(); it != pages.end(); ++it) {
+        if (it->size >= size && it->size <= maxSize &&
+            (best == pages.end() || it->size < best->size))
+            best = it;
+    }
+    if (best == pages.end())
+        return false;
+
+    taken = *best;
+    bytes -= taken.size;
+    *best = pages.back();
+    pages.pop_back();
+
+    return true;
+}
+
+// Keep a page in the cache, if it's from the current allocator and that stays within
+// 'maxCount' pages and 'limit' bytes.
+bool CachePage(std::vector<TCachedPage>& pages, size_t& bytes, size_t maxCount, int limit,
+               const TCachedPage& page)
+{
+    if (page.generation != AllocatorGeneration ||
+        pages.size() >= maxCount || bytes + page.size > (size_t)std::max(limit, 0))
+        return false;
+
+    pages.push_back(page);
+    bytes += page.size;
+
+    return true;
+}
+
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+//
+// Single pages of pools destroyed on a thread are kept for the next
+// pools made on it, up to PoolConfig.threadPageCacheSize bytes, so a
+// thread compiling one shader after another rarely goes to the OS.
+//
+struct TThreadPageCache {
+    TThreadPageCache() : bytes(0) { }
+    ~TThreadPageCache();
+
+    std::vector<TCachedPage> pages;
+    size_t bytes;
+};
+
+const size_t MaxThreadPages = 64;
+
+thread_local TThreadPageCache ThreadPages;
+
+// Set once the thread is exiting, as pools can still be deleted after ThreadPages.
+thread_local bool ThreadPagesDestroyed = false;
+
+TThreadPageCache::~TThreadPageCache()
+{
+    TrimPageCache(pages, bytes, 0);
+    ThreadPagesDestroyed = true;
+}
+#endif
+
+} // end anonymous namespace
+
+void SetPoolConfig(const TPoolConfig& config)
+{
+    PoolConfig = config;
+
+    std::lock_guard<std::mutex> lock(LargePageMutex);
+    TrimPageCache(LargePages, LargePageBytes, std::max(config.largePageCacheSize, 0));
+}
+
+void FreeLargePageCache()
+{
+    std::lock_guard<std::mutex> lock(LargePageMutex);
+    TrimPageCache(LargePages, LargePageBytes, 0);
+}
+
+void SetAllocatorCallbacks(const TAllocatorCallbacks* callbacks)
+{
+    // Don't hand out pages cached from the previous allocator.  Those cached
+    // by other threads are freed by them, on their next new page or at exit.
+    FreeLargePageCache();
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+    if (! ThreadPagesDestroyed)
+        TrimPageCache(ThreadPages.pages, ThreadPages.bytes, 0);
+#endif
+
+    if (callbacks)
+        AllocatorCallbacks = *callbacks;
+    else
+        AllocatorCallbacks = TAllocatorCallbacks{ nullptr, nullptr, nullptr };
+    ++AllocatorGeneration;
 }
 
 //
@@ -103,11 +320,25 @@ void SetThreadPoolAllocator(TPoolAllocator& poolAllocator)
 // is documented in PoolAlloc.h.
 //
 TPoolAllocator::TPoolAllocator(int growthIncrement, int allocationAlignment) :
-    pageSize(growthIncrement),
+    pageSize(growthIncrement != 0 ? growthIncrement : PoolConfig.pageSize),
+    maxPageSize(growthIncrement != 0 ? growthIncrement : PoolConfig.maxPageSize),
     alignment(allocationAlignment),
+    currentPageOffset(0),
+    currentPageEnd(0),
     freeList(nullptr),
     inUseList(nullptr),
-    numCalls(0)
+    numCalls(0),
+    totalBytes(0),
+    pagesInUse(0),
+    freePages(0),
+    bytesInUse(0),
+    peakBytesInUse(0),
+    freeBytes(0),
+    numMultiPageAllocations(0),
+    largestMultiPageAllocation(0),
+    maxStackDepth(0),
+    limit(0),
+    levelData(nullptr)
 {
     //
     // Don't allow page sizes we know are smaller than all common
@@ -115,12 +346,8 @@ TPoolAllocator::TPoolAllocator(int growthIncrement, int allocationAlignment) :
     //
     if (pageSize < 4*1024)
         pageSize = 4*1024;
-
-    //
-    // A large currentPageOffset indicates a new page needs to
-    // be obtained to allocate memory.
-    //
-    currentPageOffset = pageSize;
+    if (maxPageSize < pageSize)
+        maxPageSize = pageSize;
 
     //
     // Adjust alignment to be at least pointer aligned and
@@ -152,7 +379,7 @@ TPoolAllocator::~TPoolAllocator()
     while (inUseList) {
         tHeader* next = inUseList->nextPage;
         inUseList->~tHeader();
-        delete [] reinterpret_cast<char*>(inUseList);
+        freePage(inUseList);
         inUseList = next;
     }
 
@@ -165,11 +392,84 @@ TPoolAllocator::~TPoolAllocator()
     //
     while (freeList) {
         tHeader* next = freeList->nextPage;
-        delete [] reinterpret_cast<char*>(freeList);
+        freePage(freeList);
         freeList = next;
     }
 }
 
+//
+// Get a new page of 'size' bytes, from the large page cache if it's for a
+// multi-page allocation, or else from this thread's page cache, or else
+// from the OS.
+//
+TPoolAllocator::tHeader* TPoolAllocator::newPage(size_t size, bool multiPage)
+{
+    TCachedPage page = { nullptr, size, nullptr, nullptr, 0 };
+
+    // A cached page can be bigger than asked for, but not past the limit.
+    size_t maxSize = multiPage ? 2 * size : std::max(size, maxPageSize);
+    if (limit != 0)
+        maxSize = std::min(maxSize, std::max(size, limit - std::min(bytesInUse, limit)));
+
+    if (multiPage) {
+        std::lock_guard<std::mutex> lock(LargePageMutex);
+        TakeCachedPage(LargePages, LargePageBytes, size, maxSize, page);
+    }
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+    else if (! ThreadPagesDestroyed)
+        TakeCachedPage(ThreadPages.pages, ThreadPages.bytes, size, maxSize, page);
+#endif
+
+    if (page.memory == nullptr)
+        AllocatePageMemory(page);
+    if (page.memory == nullptr)
+        return nullptr;
+
+    // Use placement-new to initialize header
+    return new(page.memory) tHeader(nullptr, page.size, multiPage, page.generation, page.freeMemory, page.freeData);
+}
+
+//
+// Give back a page no longer in use, whose header has already been destroyed.
+//
+void TPoolAllocator::freePage(tHeader* page)
+{
+    const TCachedPage cached = { page, page->size, page->freeMemory, page->freeData, page->generation };
+
+    if (page->multiPage) {
+        std::lock_guard<std::mutex> lock(LargePageMutex);
+        if (CachePage(LargePages, LargePageBytes, MaxLargePages, PoolConfig.largePageCacheSize, cached))
+            return;
+    }
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+    else if (! ThreadPagesDestroyed) {
+        if (CachePage(ThreadPages.pages, ThreadPages.bytes, MaxThreadPages, PoolConfig.threadPageCacheSize, cached))
+            return;
+    }
+#endif
+
+    FreePageMemory(cached);
+}
+
+void TPoolAllocator::checkLimit(size_t size)
+{
+    if (limit != 0 && bytesInUse + size > limit) {
+        limit = 0;
+        throw TPoolLimitExceeded();
+    }
+}
+
+void TPoolAllocator::addInUse(tHeader* page)
+{
+    page->nextPage = inUseList;
+    inUseList = page;
+
+    ++pagesInUse;
+    bytesInUse += page->size;
+    if (bytesInUse > peakBytesInUse)
+        peakBytesInUse = bytesInUse;
+}
+
 const unsigned char TAllocation::guardBlockBeginVal = 0xfb;
 const unsigned char TAllocation::guardBlockEndVal   = 0xfe;
 const unsigned char TAllocation::userDataFill       = 0xcd;
@@ -208,14 +508,18 @@ void TAllocation::checkGuardBlock(unsigned char*, unsigned char, const char*) co
 
 void TPoolAllocator::push()
 {
-    tAllocState state = { currentPageOffset, inUseList };
+    tAllocState state = { currentPageOffset, currentPageEnd, inUseList, levelData };
 
     stack.push_back(state);
+    if (stack.size() > maxStackDepth)
+        maxStackDepth = stack.size();
+    levelData = nullptr;
 
     //
     // Indicate there is no current page to allocate from.
     //
-    currentPageOffset = pageSize;
+    currentPageOffset = 0;
+    currentPageEnd = 0;
 }
 
 //
@@ -232,17 +536,23 @@ void TPoolAllocator::pop()
 
     tHeader* page = stack.back().page;
     currentPageOffset = stack.back().offset;
+    currentPageEnd = stack.back().end;
+    levelData = stack.back().levelData;
 
     while (inUseList != page) {
         // invoke destructor to free allocation list
         inUseList->~tHeader();
 
         tHeader* nextInUse = inUseList->nextPage;
-        if (inUseList->pageCount > 1)
-            delete [] reinterpret_cast<char*>(inUseList);
+        --pagesInUse;
+        bytesInUse -= inUseList->size;
+        if (inUseList->multiPage)
+            freePage(inUseList);
         else {
             inUseList->nextPage = freeList;
             freeList = inUseList;
+            ++freePages;
+            freeBytes += inUseList->size;
         }
         inUseList = nextInUse;
     }
@@ -279,7 +589,7 @@ void* TPoolAllocator::allocate(size_t numBytes)
     // Do the allocation, most likely case first, for efficiency.
     // This step could be moved to be inline sometime.
     //
-    if (currentPageOffset + allocationSize <= pageSize) {
+    if (currentPageOffset + allocationSize <= currentPageEnd) {
         //
         // Safe to allocate from currentPageOffset.
         //
@@ -296,43 +606,70 @@ void* TPoolAllocator::allocate(size_t numBytes)
         // The OS is efficient and allocating and free-ing multiple pages.
         //
         size_t numBytesToAlloc = allocationSize + headerSkip;
-        tHeader* memory = reinterpret_cast<tHeader*>(::new char[numBytesToAlloc]);
+        checkLimit(numBytesToAlloc);
+        tHeader* memory = newPage(numBytesToAlloc, true);
         if (memory == 0)
             return 0;
 
-        // Use placement-new to initialize header
-        new(memory) tHeader(inUseList, (numBytesToAlloc + pageSize - 1) / pageSize);
-        inUseList = memory;
+        addInUse(memory);
+        ++numMultiPageAllocations;
+        if (numBytes > largestMultiPageAllocation)
+            largestMultiPageAllocation = numBytes;
 
-        currentPageOffset = pageSize;  // make next allocation come from a new page
+        // make next allocation come from a new page
+        currentPageOffset = 0;
+        currentPageEnd = 0;
 
         // No guard blocks for multi-page allocations (yet)
         return reinterpret_cast<void*>(reinterpret_cast<UINT_PTR>(memory) + headerSkip);
     }
 
     //
-    // Need a simple page to allocate from.
+    // Need a simple page to allocate from.  Reuse a free one if it's
+    // big enough, else get a new one, making the one after that bigger.
     //
     tHeader* memory;
-    if (freeList) {
+    bool reuse = freeList && freeList->size >= allocationSize + headerSkip;
+    checkLimit(reuse ? freeList->size : pageSize);
+    if (reuse) {
         memory = freeList;
         freeList = freeList->nextPage;
+        --freePages;
+        freeBytes -= memory->size;
+
+        // Use placement-new to initialize header
+        new(memory) tHeader(nullptr, memory->size, false, memory->generation, memory->freeMemory, memory->freeData);
     } else {
-        memory = reinterpret_cast<tHeader*>(::new char[pageSize]);
+        memory = newPage(pageSize, false);
         if (memory == 0)
             return 0;
+        pageSize = std::min(2 * pageSize, maxPageSize);
     }
 
-    // Use placement-new to initialize header
-    new(memory) tHeader(inUseList, 1);
-    inUseList = memory;
+    addInUse(memory);
 
     unsigned char* ret = reinterpret_cast<unsigned char*>(inUseList) + headerSkip;
     currentPageOffset = (headerSkip + allocationSize + alignmentMask) & ~alignmentMask;
+    currentPageEnd = memory->size;
 
     return initializeAllocation(inUseList, ret, numBytes);
 }
 
+void TPoolAllocator::getStats(TPoolStats& stats) const
+{
+    stats.numAllocations = numCalls;
+    stats.bytesRequested = totalBytes;
+    stats.bytesInUse = bytesInUse;
+    stats.peakBytesInUse = peakBytesInUse;
+    stats.bytesReserved = bytesInUse + freeBytes;
+    stats.pagesInUse = pagesInUse;
+    stats.freePages = freePages;
+    stats.multiPageAllocations = numMultiPageAllocations;
+    stats.largestMultiPageAllocation = largestMultiPageAllocation;
+    stats.pushDepth = (int)stack.size();
+    stats.maxPushDepth = (int)maxStackDepth;
+}
+
 //
 // Check all allocations in a list for damage by calling check on each.
 //
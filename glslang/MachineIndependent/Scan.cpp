@@ -652,6 +652,7 @@ int TScanContext::tokenize(TPpContext* pp, TParserToken& token)
             return 0;
 
         tokenText = ppToken.name;
+        this->ppToken = &ppToken;
         loc = ppToken.loc;
         parserToken->sType.lex.loc = loc;
         switch (token) {
@@ -746,17 +747,40 @@ int TScanContext::tokenize(TPpContext* pp, TParserToken& token)
     } while (true);
 }
 
+// Get what's known about the identifier being tokenized, so it's looked up
+// in the keyword tables and allocated only the first time it's seen.
+const TScanContext::TIdentifier& TScanContext::getIdentifier()
+{
+    const int atom = ppToken->atom;
+    if (atom >= (int)identifiers.size())
+        identifiers.resize(atom + 1);
+
+    TIdentifier& identifier = identifiers[atom];
+    if (identifier.string == nullptr) {
+        identifier.string = NewPoolTString(tokenText);
+        if (ReservedSet->find(tokenText) != ReservedSet->end())
+            identifier.reserved = true;
+        else {
+            auto it = KeywordMap->find(tokenText);
+            if (it != KeywordMap->end())
+                identifier.keyword = it->second;
+        }
+    }
+
+    return identifier;
+}
+
 int TScanContext::tokenizeIdentifier()
 {
-    if (ReservedSet->find(tokenText) != ReservedSet->end())
+    const TIdentifier& identifier = getIdentifier();
+    if (identifier.reserved)
         return reservedWord();
 
-    auto it = KeywordMap->find(tokenText);
-    if (it == KeywordMap->end()) {
+    if (identifier.keyword == 0) {
         // Should have an identifier of some sort
         return identifierOrType();
     }
-    keyword = it->second;
+    keyword = identifier.keyword;
 
     switch (keyword) {
     case CONST:
@@ -1268,7 +1292,7 @@ int TScanContext::tokenizeIdentifier()
 
 int TScanContext::identifierOrType()
 {
-    parserToken->sType.lex.string = NewPoolTString(tokenText);
+    parserToken->sType.lex.string = getIdentifier().string;
     if (field)
         return IDENTIFIER;
 
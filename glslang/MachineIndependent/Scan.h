@@ -217,6 +217,24 @@ public:
     // Returns the index (starting from 0) of the most recent valid source string we are reading from.
     int getLastValidSourceIndex() const { return std::min(currentSource, numSources - 1); }
 
+    // Where the next character comes from: a source string, and an offset within it.
+    int getCurrentSource() const { return currentSource; }
+    size_t getCurrentChar() const { return currentChar; }
+
+    // Move forward, within the current source string, to 'offset' (which may be its
+    // length), as get() would have, given the lines crossed and the column ended at.
+    void skipTo(size_t offset, int newLines, int column)
+    {
+        loc[currentSource].line += newLines;
+        logicalSourceLoc.line += newLines;
+        loc[currentSource].column = column;
+        logicalSourceLoc.column = column;
+        if (offset > currentChar) {
+            currentChar = offset - 1;
+            advance();
+        }
+    }
+
     void consumeWhiteSpace(bool& foundNonSpaceTab);
     bool consumeComment();
     void consumeWhitespaceComment(bool& foundNonSpaceTab);
@@ -74,6 +74,16 @@ protected:
     int firstGenerationImage(bool inEs310);
     int secondGenerationImage();
 
+    // What's known about an identifier, whatever the context.  Each
+    // identifier is learned on first sight, then found again by its atom.
+    struct TIdentifier {
+        TIdentifier() : string(nullptr), keyword(0), reserved(false) { }
+        TString* string;  // shared by all tokens for the identifier
+        int keyword;      // 0 if not a keyword
+        bool reserved;
+    };
+    const TIdentifier& getIdentifier();
+
     TParseContextBase& parseContext;
     bool afterType;           // true if we've recognized a type, so can only be looking for an identifier
     bool field;               // true if we're on a field, right after a '.'
@@ -83,6 +93,7 @@ protected:
 
     const char* tokenText;
     int keyword;
+    TVector<TIdentifier> identifiers;  // indexed by atom
 };
 
 } // end namespace glslang
@@ -41,10 +41,17 @@
 // This is the platform independent interface between an OGL driver
 // and the shading language compiler/linker.
 //
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include "SymbolTable.h"
 #include "ParseHelper.h"
 #include "Scan.h"
@@ -216,7 +223,37 @@ enum EPrecisionClass {
 TSymbolTable* CommonSymbolTable[VersionCount][SpvVersionCount][ProfileCount][SourceCount][EPcCount] = {};
 TSymbolTable* SharedSymbolTables[VersionCount][SpvVersionCount][ProfileCount][SourceCount][EShLangCount] = {};
 
-TPoolAllocator* PerProcessGPA = 0;
+// Each version/spv/profile/source slot of the tables above is built once, under
+// its own lock and into its own pool, so different slots can be built at the same
+// time.  'ready' is published only once the slot's tables are complete, so anyone
+// seeing it set can use them without taking the lock.
+//
+// Compiles sharing a slot, stage and resource limits with an earlier compile start from
+// a copy of its context-specific (resource-dependent) built-in level, rather than each
+// parsing it again.  Each of these tables adopts the slot's shared levels for the stage
+// and adds that level, read only, in a pool of its own.
+//
+struct TContextSymbolTable {
+    size_t resourcesHash;
+    TBuiltInResource resources;
+    TPoolAllocator* pool;
+    TSymbolTable* symbolTable;
+};
+
+// Past this many different resource limits, for a slot and stage, compiles go back
+// to making their own context-specific level, so odd uses can't grow memory unbounded.
+const int MaxContextSymbolTables = 16;
+
+struct TBuiltInSlot {
+    std::mutex mutex;
+    std::atomic<bool> ready;
+    TPoolAllocator* pool;
+
+    std::mutex contextMutex;
+    std::vector<TContextSymbolTable> contextTables[EShLangCount];
+};
+
+TBuiltInSlot BuiltInSlots[VersionCount][SpvVersionCount][ProfileCount][SourceCount];
 
 //
 // Parse and add to the given symbol table the content of the given shader string.
@@ -355,12 +392,99 @@ bool AddContextSpecificSymbols(const TBuiltInResource* resources, TInfoSink& inf
     return true;
 }
 
+// Only the resource limits themselves, leaving out any padding at the end.
+const size_t ResourcesSize = offsetof(TBuiltInResource, limits) + sizeof(TLimits);
+
+size_t HashResources(const TBuiltInResource& resources)
+{
+    // FNV-1a
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&resources);
+    size_t hash = 2166136261u;
+    for (size_t b = 0; b < ResourcesSize; ++b) {
+        hash ^= bytes[b];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+//
+// Find or make the table holding all the built-in levels, including the
+// context-specific one, for compiling with the given resources.  Its
+// context-specific level is read only; compiles copy it with copyTable(),
+// as they edit that level in place (e.g., sizing implicitly-sized arrays).
+//
+// Returns nullptr if that can't be shared, in which case the caller must
+// add the context-specific level itself.
+//
+// SetupBuiltinSymbolTable() must have been called for the slot.
+//
+TSymbolTable* GetContextSymbolTable(const TBuiltInResource& resources, int version, EProfile profile,
+                                    const SpvVersion& spvVersion, EShLanguage language, EShSource source)
+{
+    int versionIndex = MapVersionToIndex(version);
+    int spvVersionIndex = MapSpvVersionToIndex(spvVersion);
+    int profileIndex = MapProfileToIndex(profile);
+    int sourceIndex = MapSourceToIndex(source);
+    TSymbolTable* sharedTable = SharedSymbolTables[versionIndex][spvVersionIndex][profileIndex][sourceIndex][language];
+    if (sharedTable == nullptr)
+        return nullptr;
+
+    TBuiltInSlot& slot = BuiltInSlots[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    std::vector<TContextSymbolTable>& contextTables = slot.contextTables[language];
+    const size_t hash = HashResources(resources);
+    const auto find = [&]() -> TSymbolTable* {
+        for (auto it = contextTables.begin(); it != contextTables.end(); ++it) {
+            if (it->resourcesHash == hash && memcmp(&it->resources, &resources, ResourcesSize) == 0)
+                return it->symbolTable;
+        }
+        return nullptr;
+    };
+
+    {
+        std::lock_guard<std::mutex> guard(slot.contextMutex);
+        TSymbolTable* existing = find();
+        if (existing != nullptr || (int)contextTables.size() >= MaxContextSymbolTables)
+            return existing;
+    }
+
+    // Make one, without holding the lock, in a pool of its own.
+    TContextSymbolTable context;
+    context.resourcesHash = hash;
+    context.resources = resources;
+    context.pool = new TPoolAllocator();
+    TPoolAllocator& previousAllocator = GetThreadPoolAllocator();
+    SetThreadPoolAllocator(*context.pool);
+
+    TInfoSink infoSink;
+    context.symbolTable = new TSymbolTable;
+    context.symbolTable->adoptLevels(*sharedTable);
+    bool success = AddContextSpecificSymbols(&resources, infoSink, *context.symbolTable, version, profile,
+                                             spvVersion, language, source) &&
+                   *infoSink.info.c_str() == '\0';
+    context.symbolTable->readOnly();
+
+    SetThreadPoolAllocator(previousAllocator);
+
+    // Keep it, unless another thread made the same one meanwhile, or it's unusable.
+    std::lock_guard<std::mutex> guard(slot.contextMutex);
+    TSymbolTable* existing = find();
+    if (existing != nullptr || ! success || (int)contextTables.size() >= MaxContextSymbolTables) {
+        delete context.symbolTable;
+        delete context.pool;
+        return existing;
+    }
+    contextTables.push_back(context);
+
+    return context.symbolTable;
+}
+
 //
 // To do this on the fly, we want to leave the current state of our thread's
 // pool allocator intact, so:
 //  - Switch to a new pool for parsing the built-ins
 //  - Do the parsing, which builds the symbol table, using the new pool
-//  - Switch to the process-global pool to save a copy the resulting symbol table
+//  - Switch to the slot's own long-lived pool to save a copy the resulting symbol table
 //  - Free up the new pool used to parse the built-ins
 //  - Switch back to the original thread's pool
 //
@@ -371,19 +495,20 @@ void SetupBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& sp
 {
     TInfoSink infoSink;
 
-    // Make sure only one thread tries to do this at a time
-    glslang::GetGlobalLock();
-
     // See if it's already been done for this version/profile combination
     int versionIndex = MapVersionToIndex(version);
     int spvVersionIndex = MapSpvVersionToIndex(spvVersion);
     int profileIndex = MapProfileToIndex(profile);
     int sourceIndex = MapSourceToIndex(source);
-    if (CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][EPcGeneral]) {
-        glslang::ReleaseGlobalLock();
+    TBuiltInSlot& slot = BuiltInSlots[versionIndex][spvVersionIndex][profileIndex][sourceIndex];
+    if (slot.ready.load(std::memory_order_acquire))
+        return;
 
+    // Make sure only one thread tries to do this at a time for this slot;
+    // others wanting it wait, but those wanting a different slot don't.
+    std::lock_guard<std::mutex> guard(slot.mutex);
+    if (slot.ready.load(std::memory_order_relaxed))
         return;
-    }
 
     // Switch to a new pool
     TPoolAllocator& previousAllocator = GetThreadPoolAllocator();
@@ -401,10 +526,11 @@ void SetupBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& sp
     // Generate the local symbol tables using the new pool
     InitializeSymbolTables(infoSink, commonTable, stageTables, version, profile, spvVersion, source);
 
-    // Switch to the process-global pool
-    SetThreadPoolAllocator(*PerProcessGPA);
+    // Switch to the slot's pool, which lives until ShFinalize()
+    slot.pool = new TPoolAllocator();
+    SetThreadPoolAllocator(*slot.pool);
 
-    // Copy the local symbol tables from the new pool to the global tables using the process-global pool
+    // Copy the local symbol tables from the new pool to the global tables using the slot's pool
     for (int precClass = 0; precClass < EPcCount; ++precClass) {
         if (! commonTable[precClass]->isEmpty()) {
             CommonSymbolTable[versionIndex][spvVersionIndex][profileIndex][sourceIndex][precClass] = new TSymbolTable;
@@ -431,7 +557,126 @@ void SetupBuiltinSymbolTable(int version, EProfile profile, const SpvVersion& sp
     delete builtInPoolAllocator;
     SetThreadPoolAllocator(previousAllocator);
 
-    glslang::ReleaseGlobalLock();
+    slot.ready.store(true, std::memory_order_release);
+}
+
+//
+// Flatten all the built-in symbol tables made so far, slot by slot: the
+// version/spv/profile/source indexes, then the common tables, then the
+// per-stage tables, whose adopted common levels are implied by the slot.
+// Slots still being built are skipped.
+//
+void WriteBuiltInSymbolTables(TSymbolWriter& writer)
+{
+    for (int version = 0; version < VersionCount; ++version) {
+        for (int spvVersion = 0; spvVersion < SpvVersionCount; ++spvVersion) {
+            for (int p = 0; p < ProfileCount; ++p) {
+                for (int source = 0; source < SourceCount; ++source) {
+                    if (! BuiltInSlots[version][spvVersion][p][source].ready.load(std::memory_order_acquire))
+                        continue;
+
+                    writer.writeInt(version);
+                    writer.writeInt(spvVersion);
+                    writer.writeInt(p);
+                    writer.writeInt(source);
+                    for (int pc = 0; pc < EPcCount; ++pc) {
+                        const TSymbolTable* table = CommonSymbolTable[version][spvVersion][p][source][pc];
+                        writer.writeBool(table != nullptr);
+                        if (table != nullptr)
+                            table->serialize(writer);
+                    }
+                    for (int stage = 0; stage < EShLangCount; ++stage) {
+                        const TSymbolTable* table = SharedSymbolTables[version][spvVersion][p][source][stage];
+                        writer.writeBool(table != nullptr);
+                        if (table != nullptr)
+                            table->serialize(writer);
+                    }
+                }
+            }
+        }
+    }
+    writer.writeInt(-1);
+}
+
+//
+// Inverse of WriteBuiltInSymbolTables(), filling in only the slots not
+// already set up.  Each slot read is built in a pool of its own, as
+// SetupBuiltinSymbolTable() would, and is kept only if complete.
+//
+bool ReadBuiltInSymbolTables(TSymbolReader& reader)
+{
+    TPoolAllocator& previousAllocator = GetThreadPoolAllocator();
+
+    for (;;) {
+        int version = reader.readInt();
+        if (version < 0 || reader.hasFailed())
+            break;
+        int spvVersion = reader.readInt();
+        int p = reader.readInt();
+        int source = reader.readInt();
+        if (version >= VersionCount || spvVersion < 0 || spvVersion >= SpvVersionCount ||
+            p < 0 || p >= ProfileCount || source < 0 || source >= SourceCount) {
+            reader.fail();
+            break;
+        }
+
+        TBuiltInSlot& slot = BuiltInSlots[version][spvVersion][p][source];
+        std::lock_guard<std::mutex> guard(slot.mutex);
+
+        TPoolAllocator* pool = new TPoolAllocator();
+        SetThreadPoolAllocator(*pool);
+
+        TSymbolTable* commonTable[EPcCount] = {};
+        TSymbolTable* stageTables[EShLangCount] = {};
+        for (int pc = 0; pc < EPcCount && ! reader.hasFailed(); ++pc) {
+            if (reader.readBool()) {
+                commonTable[pc] = new TSymbolTable;
+                commonTable[pc]->deserialize(reader);
+            }
+        }
+        EProfile profile = p == MapProfileToIndex(EEsProfile) ? EEsProfile : ENoProfile;
+        for (int stage = 0; stage < EShLangCount && ! reader.hasFailed(); ++stage) {
+            if (reader.readBool()) {
+                TSymbolTable* common = commonTable[CommonIndex(profile, (EShLanguage)stage)];
+                if (common == nullptr) {
+                    reader.fail();
+                    break;
+                }
+                stageTables[stage] = new TSymbolTable;
+                stageTables[stage]->adoptLevels(*common);
+                stageTables[stage]->deserialize(reader);
+            }
+        }
+
+        // Keep what was read only if it's complete and not already present.
+        bool keep = ! reader.hasFailed() && commonTable[EPcGeneral] != nullptr &&
+                    ! slot.ready.load(std::memory_order_relaxed);
+        if (keep) {
+            for (int pc = 0; pc < EPcCount; ++pc) {
+                if (commonTable[pc] != nullptr) {
+                    commonTable[pc]->readOnly();
+                    CommonSymbolTable[version][spvVersion][p][source][pc] = commonTable[pc];
+                }
+            }
+            for (int stage = 0; stage < EShLangCount; ++stage) {
+                if (stageTables[stage] != nullptr) {
+                    stageTables[stage]->readOnly();
+                    SharedSymbolTables[version][spvVersion][p][source][stage] = stageTables[stage];
+                }
+            }
+            slot.pool = pool;
+            slot.ready.store(true, std::memory_order_release);
+        } else {
+            for (int stage = 0; stage < EShLangCount; ++stage)
+                delete stageTables[stage];
+            for (int pc = 0; pc < EPcCount; ++pc)
+                delete commonTable[pc];
+            delete pool;
+        }
+        SetThreadPoolAllocator(previousAllocator);
+    }
+
+    return ! reader.hasFailed();
 }
 
 // Return true if the shader was correctly specified for version/profile/stage.
@@ -667,7 +912,9 @@ bool ProcessDeferred(
     bool requireNonempty,
     TShader::Includer& includer,
     const std::string sourceEntryPointName = "",
-    const TEnvironment* environment = nullptr)  // optional way of fully setting all versions, overriding the above
+    const TEnvironment* environment = nullptr,  // optional way of fully setting all versions, overriding the above
+    size_t memoryLimit = 0,                     // for the pool while processing the shader; 0 for none
+    TScannedSource* scannedSource = nullptr)    // for sharing the scanning of the shader's strings
 {
     if (! InitThread())
         return false;
@@ -784,8 +1031,11 @@ bool ProcessDeferred(
 
     // Add built-in symbols that are potentially context dependent;
     // they get popped again further down.
-    if (! AddContextSpecificSymbols(resources, compiler->infoSink, symbolTable, version, profile, spvVersion,
-                                    stage, source))
+    TSymbolTable* contextTable = GetContextSymbolTable(*resources, version, profile, spvVersion, stage, source);
+    if (contextTable)
+        symbolTable.copyTable(*contextTable);
+    else if (! AddContextSpecificSymbols(resources, compiler->infoSink, symbolTable, version, profile, spvVersion,
+                                         stage, source))
         return false;
 
     //
@@ -832,13 +1082,24 @@ bool ProcessDeferred(
         names[postIndex] = nullptr;
     }
     TInputScanner fullInput(numStrings + numPre + numPost, strings, lengths, names, numPre, numPost);
+    if (scannedSource != nullptr)
+        ppContext.setScannedSource(scannedSource, strings, lengths, numPre, numStrings);
 
     // Push a new symbol allocation scope that will get used for the shader's globals.
     symbolTable.push();
 
-    bool success = processingContext(*parseContext, ppContext, fullInput,
-                                     versionWillBeError, symbolTable,
-                                     intermediate, optLevel, messages);
+    // Past the memory limit, the pool throws, unwinding the processing.
+    bool success;
+    GetThreadPoolAllocator().setLimit(memoryLimit);
+    try {
+        success = processingContext(*parseContext, ppContext, fullInput,
+                                    versionWillBeError, symbolTable,
+                                    intermediate, optLevel, messages);
+    } catch (const TPoolLimitExceeded&) {
+        compiler->infoSink.info.message(EPrefixError, "memory limit exceeded");
+        success = false;
+    }
+    GetThreadPoolAllocator().setLimit(0);
 
     // Clean up the symbol table. The AST is self-sufficient now.
     delete symbolTableMemory;
@@ -1082,14 +1343,16 @@ bool PreprocessDeferred(
     EShMessages messages,       // warnings/errors/AST; things to print out
     TShader::Includer& includer,
     TIntermediate& intermediate, // returned tree, etc.
-    std::string* outputString)
+    std::string* outputString,
+    size_t memoryLimit = 0,
+    TScannedSource* scannedSource = nullptr)
 {
     DoPreprocessing parser(outputString);
     return ProcessDeferred(compiler, shaderStrings, numStrings, inputLengths, stringNames,
                            preamble, optLevel, resources, defaultVersion,
                            defaultProfile, forceDefaultVersionAndProfile,
                            forwardCompatible, messages, intermediate, parser,
-                           false, includer);
+                           false, includer, "", nullptr, memoryLimit, scannedSource);
 }
 
 //
@@ -1120,14 +1383,16 @@ bool CompileDeferred(
     TIntermediate& intermediate,// returned tree, etc.
     TShader::Includer& includer,
     const std::string sourceEntryPointName = "",
-    TEnvironment* environment = nullptr)
+    TEnvironment* environment = nullptr,
+    size_t memoryLimit = 0,
+    TScannedSource* scannedSource = nullptr)
 {
     DoFullParse parser;
     return ProcessDeferred(compiler, shaderStrings, numStrings, inputLengths, stringNames,
                            preamble, optLevel, resources, defaultVersion,
                            defaultProfile, forceDefaultVersionAndProfile,
                            forwardCompatible, messages, intermediate, parser,
-                           true, includer, sourceEntryPointName, environment);
+                           true, includer, sourceEntryPointName, environment, memoryLimit, scannedSource);
 }
 
 } // end anonymous namespace for local functions
@@ -1142,9 +1407,6 @@ int ShInitialize()
     if (! InitProcess())
         return 0;
 
-    if (! PerProcessGPA)
-        PerProcessGPA = new TPoolAllocator();
-
     glslang::TScanContext::fillInKeywordMap();
 #ifdef ENABLE_HLSL
     glslang::HlslScanContext::fillInKeywordMap();
@@ -1234,10 +1496,24 @@ int __fastcall ShFinalize()
         }
     }
 
-    if (PerProcessGPA) {
-        PerProcessGPA->popAll();
-        delete PerProcessGPA;
-        PerProcessGPA = 0;
+    for (int version = 0; version < VersionCount; ++version) {
+        for (int spvVersion = 0; spvVersion < SpvVersionCount; ++spvVersion) {
+            for (int p = 0; p < ProfileCount; ++p) {
+                for (int source = 0; source < SourceCount; ++source) {
+                    TBuiltInSlot& slot = BuiltInSlots[version][spvVersion][p][source];
+                    for (int stage = 0; stage < EShLangCount; ++stage) {
+                        for (auto& context : slot.contextTables[stage]) {
+                            delete context.symbolTable;
+                            delete context.pool;
+                        }
+                        slot.contextTables[stage].clear();
+                    }
+                    delete slot.pool;
+                    slot.pool = nullptr;
+                    slot.ready.store(false, std::memory_order_relaxed);
+                }
+            }
+        }
     }
 
     glslang::TScanContext::deleteKeywordMap();
@@ -1245,6 +1521,9 @@ int __fastcall ShFinalize()
     glslang::HlslScanContext::deleteKeywordMap();
 #endif
 
+    glslang::FreeLargePageCache();
+    glslang::FreeIncludeCache();
+
     return 1;
 }
 
@@ -1536,11 +1815,132 @@ bool InitializeProcess()
     return ShInitialize() != 0;
 }
 
+bool InitializeProcess(const char* builtInCacheFileName)
+{
+    if (! InitializeProcess())
+        return false;
+
+    // a missing or stale cache just means parsing built-ins as needed
+    LoadBuiltInSymbolTables(builtInCacheFileName);
+
+    return true;
+}
+
 void FinalizeProcess()
 {
     ShFinalize();
 }
 
+//
+// Built-in symbol-table files hold memory images only meaningful to
+// the build that wrote them, so they start with a description of it.
+//
+namespace {
+
+const char BuiltInCacheMagic[] = "glslang built-in symbol tables";
+
+std::string BuiltInCacheFingerprint()
+{
+    std::ostringstream fingerprint;
+    fingerprint << GLSLANG_REVISION " " GLSLANG_DATE
+                << " " << sizeof(void*) << " " << sizeof(TQualifier) << " " << sizeof(TSampler)
+                << " " << sizeof(TConstUnion) << " " << EbtNumTypes << " " << EvqLast
+                << " " << EbvLast << " " << EOpMatrixSwizzle;
+#ifdef AMD_EXTENSIONS
+    fingerprint << " AMD";
+#endif
+#ifdef NV_EXTENSIONS
+    fingerprint << " NV";
+#endif
+#ifdef ENABLE_HLSL
+    fingerprint << " HLSL";
+#endif
+
+    return fingerprint.str();
+}
+
+} // end anonymous namespace
+
+bool SaveBuiltInSymbolTables(const char* fileName)
+{
+    TSymbolWriter writer;
+    writer.writeString(BuiltInCacheMagic);
+    writer.writeString(BuiltInCacheFingerprint().c_str());
+
+    WriteBuiltInSymbolTables(writer);
+
+    if (writer.hasFailed())
+        return false;
+
+    std::ofstream stream(fileName, std::ios::binary | std::ios::trunc);
+    if (! stream)
+        return false;
+    stream.write(writer.getData().data(), writer.getData().size());
+
+    return stream.good();
+}
+
+bool LoadBuiltInSymbolTables(const char* fileName)
+{
+    std::ifstream stream(fileName, std::ios::binary);
+    if (! stream)
+        return false;
+    std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    TSymbolReader reader(data.data(), data.size());
+    TString* magic = reader.readString();
+    TString* fingerprint = reader.readString();
+
+    return magic != nullptr && *magic == BuiltInCacheMagic &&
+           fingerprint != nullptr && *fingerprint == BuiltInCacheFingerprint().c_str() &&
+           ReadBuiltInSymbolTables(reader) && reader.atEnd();
+}
+
+bool WarmUpBuiltInSymbolTables(const TBuiltInWarmUp* warmUps, int count, int numThreads)
+{
+    std::atomic<int> next(0);
+    std::atomic<bool> allCorrect(true);
+
+    // Each thread takes the next warm-up not yet taken, until there are none.
+    const auto warmUpSome = [&]() {
+        if (! InitThread()) {
+            allCorrect = false;
+            return;
+        }
+
+        for (int w = next++; w < count; w = next++) {
+            // Set up the environment, version and profile as ProcessDeferred() would.
+            EShMessages messages = warmUps[w].messages;
+            EShSource source = (messages & EShMsgReadHlsl) != 0 ? EShSourceHlsl : EShSourceGlsl;
+            EShLanguage stage = warmUps[w].stage;
+            SpvVersion spvVersion;
+            TranslateEnvironment(warmUps[w].environment, messages, source, stage, spvVersion);
+
+            TInfoSink infoSink;
+            int version = warmUps[w].version;
+            EProfile profile = warmUps[w].profile;
+            if (! DeduceVersionProfile(infoSink, stage, false, version, source, version, profile, spvVersion))
+                allCorrect = false;
+
+            SetupBuiltinSymbolTable(version, profile, spvVersion, source);
+        }
+    };
+
+    // The calling thread is one of them.
+    std::vector<std::thread> threads;
+    for (int t = 1; t < std::min(numThreads, count); ++t) {
+        threads.push_back(std::thread([&warmUpSome]() {
+            warmUpSome();
+            DetachThread();
+        }));
+    }
+    warmUpSome();
+    for (auto& thread : threads)
+        thread.join();
+
+    return allCorrect;
+}
+
 class TDeferredCompiler : public TCompiler {
 public:
     TDeferredCompiler(EShLanguage s, TInfoSink& i) : TCompiler(s, i) { }
@@ -1548,7 +1948,7 @@ public:
 };
 
 TShader::TShader(EShLanguage s)
-    : pool(0), stage(s), lengths(nullptr), stringNames(nullptr), preamble("")
+    : pool(0), stage(s), lengths(nullptr), stringNames(nullptr), preamble(""), memoryLimit(0), scannedSource(nullptr)
 {
     infoSink = new TInfoSink;
     compiler = new TDeferredCompiler(stage, *infoSink);
@@ -1647,7 +2047,7 @@ bool TShader::parse(const TBuiltInResource* builtInResources, int defaultVersion
                            preamble, EShOptNone, builtInResources, defaultVersion,
                            defaultProfile, forceDefaultVersionAndProfile,
                            forwardCompatible, messages, *intermediate, includer, sourceEntryPointName,
-                           &environment);
+                           &environment, memoryLimit, scannedSource);
 }
 
 // Fill in a string with the result of preprocessing ShaderStrings
@@ -1670,7 +2070,8 @@ bool TShader::preprocess(const TBuiltInResource* builtInResources,
     return PreprocessDeferred(compiler, strings, numStrings, lengths, stringNames, preamble,
                               EShOptNone, builtInResources, defaultVersion,
                               defaultProfile, forceDefaultVersionAndProfile,
-                              forwardCompatible, message, includer, *intermediate, output_string);
+                              forwardCompatible, message, includer, *intermediate, output_string,
+                              memoryLimit, scannedSource);
 }
 
 const char* TShader::getInfoLog()
@@ -1683,12 +2084,20 @@ const char* TShader::getInfoDebugLog()
     return infoSink->debug.c_str();
 }
 
+void TShader::getPoolStats(TPoolStats& stats) const
+{
+    stats = TPoolStats();
+    if (pool)
+        pool->getStats(stats);
+}
+
 TProgram::TProgram() : pool(0), reflection(0), ioMapper(nullptr), linked(false)
 {
     infoSink = new TInfoSink;
     for (int s = 0; s < EShLangCount; ++s) {
         intermediate[s] = 0;
         newedIntermediate[s] = false;
+        stagePools[s] = nullptr;
     }
 }
 
@@ -1702,6 +2111,9 @@ TProgram::~TProgram()
         if (newedIntermediate[s])
             delete intermediate[s];
 
+    for (int s = 0; s < EShLangCount; ++s)
+        delete stagePools[s];
+
     delete pool;
 }
 
@@ -1712,6 +2124,11 @@ TProgram::~TProgram()
 // Return true for success.
 //
 bool TProgram::link(EShMessages messages)
+{
+    return link(messages, 1);
+}
+
+bool TProgram::link(EShMessages messages, int numThreads)
 {
     if (linked)
         return false;
@@ -1722,9 +2139,57 @@ bool TProgram::link(EShMessages messages)
     pool = new TPoolAllocator();
     SetThreadPoolAllocator(*pool);
 
+    std::vector<EShLanguage> stagesToLink;
     for (int s = 0; s < EShLangCount; ++s) {
-        if (! linkStage((EShLanguage)s, messages))
-            error = true;
+        if (stages[s].size() > 0)
+            stagesToLink.push_back((EShLanguage)s);
+    }
+
+    if (numThreads <= 1 || stagesToLink.size() <= 1) {
+        for (int s = 0; s < EShLangCount; ++s) {
+            if (! linkStage((EShLanguage)s, messages, *infoSink))
+                error = true;
+        }
+    } else {
+        // Stages don't share anything while being linked, so each links in a pool and
+        // info sink of its own.  The info sinks are appended in stage order afterward.
+        TInfoSink stageInfoSinks[EShLangCount];
+        bool stageLinked[EShLangCount];
+        std::atomic<int> next(0);
+
+        // Each thread takes the next stage not yet taken, until there are none.
+        const auto linkSome = [&]() {
+            for (int i = next++; i < (int)stagesToLink.size(); i = next++) {
+                EShLanguage stage = stagesToLink[i];
+                stagePools[stage] = new TPoolAllocator();
+                SetThreadPoolAllocator(*stagePools[stage]);
+                stageLinked[stage] = linkStage(stage, messages, stageInfoSinks[stage]);
+            }
+        };
+
+        // The calling thread is one of them.
+        std::vector<std::thread> threads;
+        for (int t = 1; t < std::min(numThreads, (int)stagesToLink.size()); ++t) {
+            threads.push_back(std::thread([&linkSome]() {
+                if (! InitThread())
+                    return;
+                TPoolAllocator& threadPool = GetThreadPoolAllocator();
+                linkSome();
+                SetThreadPoolAllocator(threadPool);
+                DetachThread();
+            }));
+        }
+        linkSome();
+        for (auto& thread : threads)
+            thread.join();
+        SetThreadPoolAllocator(*pool);
+
+        for (EShLanguage stage : stagesToLink) {
+            infoSink->info << stageInfoSinks[stage].info.c_str();
+            infoSink->debug << stageInfoSinks[stage].debug.c_str();
+            if (! stageLinked[stage])
+                error = true;
+        }
     }
 
     // TODO: Link: cross-stage error checking
@@ -1733,11 +2198,12 @@ bool TProgram::link(EShMessages messages)
 }
 
 //
-// Merge the compilation units within the given stage into a single TIntermediate.
+// Merge the compilation units within the given stage into a single TIntermediate,
+// reporting into the given info sink.
 //
 // Return true for success.
 //
-bool TProgram::linkStage(EShLanguage stage, EShMessages messages)
+bool TProgram::linkStage(EShLanguage stage, EShMessages messages, TInfoSink& infoSink)
 {
     if (stages[stage].size() == 0)
         return true;
@@ -1752,10 +2218,10 @@ bool TProgram::linkStage(EShLanguage stage, EShMessages messages)
     }
 
     if (numEsShaders > 0 && numNonEsShaders > 0) {
-        infoSink->info.message(EPrefixError, "Cannot mix ES profile with non-ES profile shaders");
+        infoSink.info.message(EPrefixError, "Cannot mix ES profile with non-ES profile shaders");
         return false;
     } else if (numEsShaders > 1) {
-        infoSink->info.message(EPrefixError, "Cannot attach multiple ES shaders of the same type to a single program");
+        infoSink.info.message(EPrefixError, "Cannot attach multiple ES shaders of the same type to a single program");
         return false;
     }
 
@@ -1783,18 +2249,18 @@ bool TProgram::linkStage(EShLanguage stage, EShMessages messages)
     }
 
     if (messages & EShMsgAST)
-        infoSink->info << "\nLinked " << StageName(stage) << " stage:\n\n";
+        infoSink.info << "\nLinked " << StageName(stage) << " stage:\n\n";
 
     if (stages[stage].size() > 1) {
         std::list<TShader*>::const_iterator it;
         for (it = stages[stage].begin(); it != stages[stage].end(); ++it)
-            intermediate[stage]->merge(*infoSink, *(*it)->intermediate);
+            intermediate[stage]->merge(infoSink, *(*it)->intermediate);
     }
 
-    intermediate[stage]->finalCheck(*infoSink, (messages & EShMsgKeepUncalled) != 0);
+    intermediate[stage]->finalCheck(infoSink, (messages & EShMsgKeepUncalled) != 0);
 
     if (messages & EShMsgAST)
-        intermediate[stage]->output(*infoSink, true);
+        intermediate[stage]->output(infoSink, true);
 
     return intermediate[stage]->getNumErrors() == 0;
 }
@@ -1809,6 +2275,20 @@ const char* TProgram::getInfoDebugLog()
     return infoSink->debug.c_str();
 }
 
+void TProgram::getPoolStats(TPoolStats& stats) const
+{
+    stats = TPoolStats();
+    if (pool)
+        pool->getStats(stats);
+    for (int s = 0; s < EShLangCount; ++s) {
+        if (stagePools[s]) {
+            TPoolStats stageStats;
+            stagePools[s]->getStats(stageStats);
+            stats += stageStats;
+        }
+    }
+}
+
 //
 // Reflection implementation.
 //
@@ -1871,4 +2351,94 @@ bool TProgram::mapIO(TIoMapResolver* resolver)
     return true;
 }
 
+TCompileBatch::TCompileBatch(int numThreads) : numThreads(numThreads), numRun(0)
+{
+}
+
+TCompileBatch::~TCompileBatch()
+{
+    for (auto& result : results)
+        delete result.program;
+}
+
+int TCompileBatch::add(const TJob& job)
+{
+    jobs.push_back(job);
+    results.push_back(TResult());
+
+    return (int)jobs.size() - 1;
+}
+
+bool TCompileBatch::run()
+{
+    const int numJobs = (int)jobs.size();
+    std::atomic<int> next(numRun);
+    std::atomic<bool> allSucceeded(true);
+
+    // Each thread takes the next job not yet taken, until there are none.
+    const auto runSome = [&]() {
+        for (int j = next++; j < numJobs; j = next++) {
+            if (! runJob(j))
+                allSucceeded = false;
+        }
+    };
+
+    // The calling thread is one of them.  Every thread leaves with the pool
+    // it came with, as the shaders and programs keep theirs.
+    std::vector<std::thread> threads;
+    for (int t = 1; t < std::min(numThreads, numJobs - numRun); ++t) {
+        threads.push_back(std::thread([&runSome]() {
+            if (! InitThread())
+                return;
+            TPoolAllocator& threadPool = GetThreadPoolAllocator();
+            runSome();
+            SetThreadPoolAllocator(threadPool);
+            DetachThread();
+        }));
+    }
+    TPoolAllocator& callerPool = GetThreadPoolAllocator();
+    runSome();
+    SetThreadPoolAllocator(callerPool);
+    for (auto& thread : threads)
+        thread.join();
+
+    numRun = numJobs;
+
+    return allSucceeded;
+}
+
+//
+// Parse all the job's shaders, and link them, if asked to.
+//
+// Return true for success.
+//
+bool TCompileBatch::runJob(int j)
+{
+    const TJob& job = jobs[j];
+    TResult& result = results[j];
+
+    TShader::ForbidIncluder forbidIncluder;
+    TShader::Includer& includer = job.includer != nullptr ? *job.includer : forbidIncluder;
+
+    result.success = true;
+    for (TShader* shader : job.shaders) {
+        if (! shader->parse(job.resources, job.defaultVersion, job.defaultProfile, job.forceDefaultVersionAndProfile,
+                            job.forwardCompatible, job.messages, includer))
+            result.success = false;
+    }
+
+    if (job.link) {
+        result.program = new TProgram;
+        for (TShader* shader : job.shaders)
+            result.program->addShader(shader);
+        if (! result.program->link(job.messages))
+            result.success = false;
+
+        if (result.success)
+            linked(j, *result.program);
+    }
+
+    return result.success;
+}
+
 } // end namespace glslang
@@ -41,12 +41,157 @@
 
 #include "SymbolTable.h"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <unordered_set>
+
 namespace glslang {
 
 //
 // TType helper function needs a place to live.
 //
 
+namespace {
+
+// Qualifiers are mostly bit-fields, whose unused bits are undefined, so they
+// are compared field by field rather than as memory.
+struct TSameQualifier {
+    bool operator()(const TQualifier* left, const TQualifier* right) const
+    {
+        return left->semanticName == right->semanticName &&
+               left->storage == right->storage &&
+               left->builtIn == right->builtIn &&
+               left->declaredBuiltIn == right->declaredBuiltIn &&
+               left->precision == right->precision &&
+               left->invariant == right->invariant &&
+               left->noContraction == right->noContraction &&
+               left->centroid == right->centroid &&
+               left->smooth == right->smooth &&
+               left->flat == right->flat &&
+               left->nopersp == right->nopersp &&
+#ifdef AMD_EXTENSIONS
+               left->explicitInterp == right->explicitInterp &&
+#endif
+               left->patch == right->patch &&
+               left->sample == right->sample &&
+               left->coherent == right->coherent &&
+               left->volatil == right->volatil &&
+               left->restrict == right->restrict &&
+               left->readonly == right->readonly &&
+               left->writeonly == right->writeonly &&
+               left->specConstant == right->specConstant &&
+               left->layoutMatrix == right->layoutMatrix &&
+               left->layoutPacking == right->layoutPacking &&
+               left->layoutOffset == right->layoutOffset &&
+               left->layoutAlign == right->layoutAlign &&
+               left->layoutLocation == right->layoutLocation &&
+               left->layoutComponent == right->layoutComponent &&
+               left->layoutSet == right->layoutSet &&
+               left->layoutBinding == right->layoutBinding &&
+               left->layoutIndex == right->layoutIndex &&
+               left->layoutStream == right->layoutStream &&
+               left->layoutXfbBuffer == right->layoutXfbBuffer &&
+               left->layoutXfbStride == right->layoutXfbStride &&
+               left->layoutXfbOffset == right->layoutXfbOffset &&
+               left->layoutAttachment == right->layoutAttachment &&
+               left->layoutSpecConstantId == right->layoutSpecConstantId &&
+               left->layoutFormat == right->layoutFormat &&
+#ifdef NV_EXTENSIONS
+               left->layoutPassthrough == right->layoutPassthrough &&
+               left->layoutViewportRelative == right->layoutViewportRelative &&
+               left->layoutSecondaryViewportRelativeOffset == right->layoutSecondaryViewportRelativeOffset &&
+#endif
+               left->layoutPushConstant == right->layoutPushConstant;
+    }
+};
+
+struct THashQualifier {
+    size_t operator()(const TQualifier* qualifier) const
+    {
+        size_t hash = std::hash<const char*>()(qualifier->semanticName);
+        hash = hash * 31 + qualifier->storage;
+        hash = hash * 31 + qualifier->builtIn;
+        hash = hash * 31 + qualifier->precision;
+        hash = hash * 31 + qualifier->layoutLocation;
+        hash = hash * 31 + qualifier->layoutSet;
+        hash = hash * 31 + qualifier->layoutBinding;
+        hash = hash * 31 + (unsigned int)qualifier->layoutOffset;
+
+        return hash;
+    }
+};
+
+// The interned qualifiers of one push() level of a pool.
+typedef std::unordered_set<const TQualifier*, THashQualifier, TSameQualifier,
+                           pool_allocator<const TQualifier*> > TQualifierSet;
+
+// The qualifiers that are cleared but for storage and precision, which are
+// most of them, shared by all types in the process.
+struct TClearedQualifiers {
+    TClearedQualifiers()
+    {
+        for (int storage = 0; storage < EvqLast; ++storage) {
+            for (int precision = 0; precision <= EpqHigh; ++precision) {
+                TQualifier& qualifier = qualifiers[storage][precision];
+                qualifier.clear();
+                qualifier.storage = (TStorageQualifier)storage;
+                qualifier.precision = (TPrecisionQualifier)precision;
+            }
+        }
+    }
+
+    bool contains(const TQualifier* qualifier) const
+    {
+        std::less<const TQualifier*> before;
+        return ! before(qualifier, &qualifiers[0][0]) && before(qualifier, &qualifiers[EvqLast - 1][EpqHigh] + 1);
+    }
+
+    TQualifier qualifiers[EvqLast][EpqHigh + 1];
+};
+
+const TClearedQualifiers& ClearedQualifiers()
+{
+    static const TClearedQualifiers cleared;
+
+    return cleared;
+}
+
+} // end anonymous namespace
+
+const TQualifier* GetClearedQualifier(TStorageQualifier storage, TPrecisionQualifier precision)
+{
+    return &ClearedQualifiers().qualifiers[storage][precision];
+}
+
+const TQualifier* InternQualifier(const TQualifier& qualifier)
+{
+    const TClearedQualifiers& cleared = ClearedQualifiers();
+    if (cleared.contains(&qualifier))
+        return &qualifier;
+    if (qualifier.storage < EvqLast && qualifier.precision <= EpqHigh) {
+        const TQualifier* clearedForm = &cleared.qualifiers[qualifier.storage][qualifier.precision];
+        if (TSameQualifier()(&qualifier, clearedForm))
+            return clearedForm;
+    }
+
+    TPoolAllocator& pool = GetThreadPoolAllocator();
+    TQualifierSet* interned = static_cast<TQualifierSet*>(pool.getLevelData());
+    if (interned == nullptr) {
+        interned = new(pool.allocate(sizeof(TQualifierSet))) TQualifierSet;
+        pool.setLevelData(interned);
+    }
+
+    auto it = interned->find(&qualifier);
+    if (it != interned->end())
+        return *it;
+
+    const TQualifier* copy = new(pool.allocate(sizeof(TQualifier))) TQualifier(qualifier);
+    interned->insert(copy);
+
+    return copy;
+}
+
 //
 // Recursively generate mangled names.
 //
@@ -219,34 +364,37 @@ TSymbolTableLevel::~TSymbolTableLevel()
 //
 void TSymbolTableLevel::relateToOperator(const char* name, TOperator op)
 {
-    tLevel::const_iterator candidate = level.lower_bound(name);
-    while (candidate != level.end()) {
-        const TString& candidateName = (*candidate).first;
-        TString::size_type parenAt = candidateName.find_first_of('(');
-        if (parenAt != candidateName.npos && candidateName.compare(0, parenAt, name) == 0) {
-            TFunction* function = (*candidate).second->getAsFunction();
-            function->relateToOperator(op);
-        } else
-            break;
-        ++candidate;
-    }
+    tOverloads::iterator it = overloads.find(name);
+    if (it == overloads.end())
+        return;
+
+    for (TFunction* function : it->second)
+        function->relateToOperator(op);
 }
 
 // Make all function overloads of the given name require an extension(s).
 // Should only be used for a version/profile that actually needs the extension(s).
 void TSymbolTableLevel::setFunctionExtensions(const char* name, int num, const char* const extensions[])
 {
-    tLevel::const_iterator candidate = level.lower_bound(name);
-    while (candidate != level.end()) {
-        const TString& candidateName = (*candidate).first;
-        TString::size_type parenAt = candidateName.find_first_of('(');
-        if (parenAt != candidateName.npos && candidateName.compare(0, parenAt, name) == 0) {
-            TSymbol* symbol = candidate->second;
-            symbol->setExtensions(num, extensions);
-        } else
-            break;
-        ++candidate;
-    }
+    tOverloads::iterator it = overloads.find(name);
+    if (it == overloads.end())
+        return;
+
+    for (TFunction* function : it->second)
+        function->setExtensions(num, extensions);
+}
+
+//
+// Index a function just inserted into 'level' under its non-function-style
+// name, keeping each set of overloads in the same order as 'level'.
+//
+void TSymbolTableLevel::insertOverload(TFunction& function)
+{
+    TVector<TFunction*>& list = overloads[function.getName()];
+    const auto mangledLess = [](const TFunction* left, const TFunction* right) {
+        return left->getMangledName() < right->getMangledName();
+    };
+    list.insert(std::upper_bound(list.begin(), list.end(), &function, mangledLess), &function);
 }
 
 //
@@ -371,4 +519,414 @@ void TSymbolTable::copyTable(const TSymbolTable& copyOf)
         table.push_back(copyOf.table[i]->clone());
 }
 
+//
+// Binary form of the shared built-in levels.
+//
+// This is a flat encoding of exactly what copyTable() would copy; reading it
+// back builds the same symbols in the current pool, without parsing anything.
+//
+
+void TSymbolWriter::write(const void* bytes, size_t size)
+{
+    const char* c = static_cast<const char*>(bytes);
+    data.insert(data.end(), c, c + size);
+}
+
+void TSymbolWriter::writeString(const char* s)
+{
+    if (s == nullptr) {
+        writeInt(-1);
+        return;
+    }
+
+    int size = (int)strlen(s);
+    writeInt(size);
+    write(s, size);
+}
+
+bool TSymbolReader::read(void* bytes, size_t size)
+{
+    if (failed || (size_t)(end - current) < size) {
+        failed = true;
+        return false;
+    }
+
+    memcpy(bytes, current, size);
+    current += size;
+
+    return true;
+}
+
+int TSymbolReader::readInt()
+{
+    int i = 0;
+    read(&i, sizeof(i));
+
+    return i;
+}
+
+TString* TSymbolReader::readString()
+{
+    int size = readInt();
+    if (size < 0 || failed) {
+        if (size != -1)
+            failed = true;
+        return nullptr;
+    }
+    if ((size_t)(end - current) < (size_t)size) {
+        failed = true;
+        return nullptr;
+    }
+
+    void* memory = GetThreadPoolAllocator().allocate(sizeof(TString));
+    TString* s = new(memory) TString(current, size);
+    current += size;
+
+    return s;
+}
+
+void TType::serialize(TSymbolWriter& writer) const
+{
+    writer.writeInt(basicType);
+    writer.writeInt(vectorSize);
+    writer.writeInt(matrixCols);
+    writer.writeInt(matrixRows);
+    writer.writeBool(vector1);
+
+    // other than the semantic name, qualifiers and samplers are plain bits
+    TQualifier bits = *qualifier;
+    bits.semanticName = nullptr;
+    writer.write(&bits, sizeof(bits));
+    writer.writeString(qualifier->semanticName);
+    writer.write(&sampler, sizeof(sampler));
+
+    if (arraySizes) {
+        writer.writeInt(arraySizes->getNumDims());
+        for (int d = 0; d < arraySizes->getNumDims(); ++d) {
+            // specialization-constant sizes are subtrees, which have no binary form
+            if (arraySizes->getDimNode(d) != nullptr)
+                writer.fail();
+            writer.writeInt(arraySizes->getDimSize(d));
+        }
+        writer.writeInt(arraySizes->getImplicitSize());
+    } else
+        writer.writeInt(-1);
+
+    // like deepCopy(), but not preserving sharing within the graph
+    if (structure) {
+        writer.writeInt((int)structure->size());
+        for (unsigned int i = 0; i < structure->size(); ++i) {
+            const TSourceLoc& loc = (*structure)[i].loc;
+            writer.writeString(loc.name);
+            writer.writeInt(loc.string);
+            writer.writeInt(loc.line);
+            writer.writeInt(loc.column);
+            (*structure)[i].type->serialize(writer);
+        }
+    } else
+        writer.writeInt(-1);
+
+    writer.writeString(fieldName ? fieldName->c_str() : nullptr);
+    writer.writeString(typeName ? typeName->c_str() : nullptr);
+}
+
+bool TType::deserialize(TSymbolReader& reader)
+{
+    basicType = (TBasicType)reader.readInt();
+    vectorSize = reader.readInt();
+    matrixCols = reader.readInt();
+    matrixRows = reader.readInt();
+    vector1 = reader.readBool();
+
+    TQualifier bits;
+    reader.read(&bits, sizeof(bits));
+    TString* semanticName = reader.readString();
+    bits.semanticName = semanticName ? semanticName->c_str() : nullptr;
+    setQualifier(bits);
+    reader.read(&sampler, sizeof(sampler));
+
+    arraySizes = nullptr;
+    int numDims = reader.readInt();
+    if (numDims >= 0 && ! reader.hasFailed()) {
+        arraySizes = new TArraySizes;
+        for (int d = 0; d < numDims && ! reader.hasFailed(); ++d)
+            arraySizes->addInnerSize(reader.readInt());
+        arraySizes->setImplicitSize(reader.readInt());
+    }
+
+    structure = nullptr;
+    int numMembers = reader.readInt();
+    if (numMembers >= 0 && ! reader.hasFailed()) {
+        structure = new TTypeList;
+        for (int i = 0; i < numMembers && ! reader.hasFailed(); ++i) {
+            TTypeLoc typeLoc;
+            TString* locName = reader.readString();
+            typeLoc.loc.name = locName ? locName->c_str() : nullptr;
+            typeLoc.loc.string = reader.readInt();
+            typeLoc.loc.line = reader.readInt();
+            typeLoc.loc.column = reader.readInt();
+            typeLoc.type = new TType();
+            typeLoc.type->deserialize(reader);
+            structure->push_back(typeLoc);
+        }
+    }
+
+    fieldName = reader.readString();
+    typeName = reader.readString();
+
+    return ! reader.hasFailed();
+}
+
+void TSymbol::serializeExtensions(TSymbolWriter& writer) const
+{
+    writer.writeInt(numExtensions);
+    for (int e = 0; e < numExtensions; ++e)
+        writer.writeString(extensions[e]);
+}
+
+bool TSymbol::deserializeExtensions(TSymbolReader& reader)
+{
+    int num = reader.readInt();
+    if (num <= 0 || reader.hasFailed())
+        return ! reader.hasFailed();
+
+    // The originals point at the static extension-name strings; extensions
+    // are compared by name, so pointing at pool copies is equivalent.
+    const char** names = NewPoolObject((const char*)nullptr, num);
+    for (int e = 0; e < num; ++e) {
+        TString* extension = reader.readString();
+        if (extension == nullptr) {
+            reader.fail();
+            return false;
+        }
+        names[e] = extension->c_str();
+    }
+    setExtensions(num, names);
+
+    return true;
+}
+
+// Tags for what follows in the binary form of a level.
+enum TSerializedSymbol {
+    EssEndOfLevel,
+    EssVariable,
+    EssFunction,
+    EssAnonContainer,
+};
+
+void TVariable::serialize(TSymbolWriter& writer) const
+{
+    writer.writeString(getName().c_str());
+    writer.writeInt(uniqueId);
+    type.serialize(writer);
+    writer.writeBool(userType);
+    serializeExtensions(writer);
+
+    writer.writeInt(constArray.size());
+    for (int i = 0; i < constArray.size(); ++i)
+        writer.write(&constArray[i], sizeof(TConstUnion));
+
+    // as with clone(), specialization-constant subtrees are not supported
+    if (constSubtree != nullptr)
+        writer.fail();
+}
+
+TVariable* TVariable::deserialize(TSymbolReader& reader)
+{
+    TString* name = reader.readString();
+    if (name == nullptr) {
+        reader.fail();
+        return nullptr;
+    }
+    int id = reader.readInt();
+    TType type;
+    type.deserialize(reader);
+    bool userType = reader.readBool();
+
+    TVariable* variable = new TVariable(name, type, userType);
+    variable->setUniqueId(id);
+    variable->deserializeExtensions(reader);
+
+    int size = reader.readInt();
+    if (size > 0 && ! reader.hasFailed()) {
+        TConstUnionArray constArray(size);
+        for (int i = 0; i < size && ! reader.hasFailed(); ++i)
+            reader.read(&constArray[i], sizeof(TConstUnion));
+        variable->setConstArray(constArray);
+    }
+
+    return variable;
+}
+
+void TFunction::serialize(TSymbolWriter& writer) const
+{
+    writer.writeString(getName().c_str());
+    writer.writeString(mangledName.c_str());
+    writer.writeInt(uniqueId);
+    returnType.serialize(writer);
+    writer.writeInt(declaredBuiltIn);
+    writer.writeInt(op);
+    writer.writeBool(defined);
+    writer.writeBool(prototyped);
+    writer.writeBool(implicitThis);
+    writer.writeBool(illegalImplicitThis);
+    serializeExtensions(writer);
+
+    writer.writeInt((int)parameters.size());
+    for (unsigned int i = 0; i < parameters.size(); ++i) {
+        writer.writeString(parameters[i].name ? parameters[i].name->c_str() : nullptr);
+        parameters[i].type->serialize(writer);
+        // default arguments are subtrees, which have no binary form
+        if (parameters[i].defaultValue != nullptr)
+            writer.fail();
+    }
+}
+
+TFunction* TFunction::deserialize(TSymbolReader& reader)
+{
+    TString* name = reader.readString();
+    TString* mangledName = reader.readString();
+    if (name == nullptr || mangledName == nullptr) {
+        reader.fail();
+        return nullptr;
+    }
+    int id = reader.readInt();
+    TType returnType;
+    returnType.deserialize(reader);
+
+    TFunction* function = new TFunction(name, returnType);
+    function->mangledName = *mangledName;
+    function->setUniqueId(id);
+    function->declaredBuiltIn = (TBuiltInVariable)reader.readInt();
+    function->op = (TOperator)reader.readInt();
+    function->defined = reader.readBool();
+    function->prototyped = reader.readBool();
+    function->implicitThis = reader.readBool();
+    function->illegalImplicitThis = reader.readBool();
+    function->deserializeExtensions(reader);
+
+    int numParams = reader.readInt();
+    for (int i = 0; i < numParams && ! reader.hasFailed(); ++i) {
+        TParameter param = { reader.readString(), new TType, nullptr };
+        param.type->deserialize(reader);
+        function->parameters.push_back(param);
+    }
+
+    return function;
+}
+
+void TAnonMember::serialize(TSymbolWriter& writer) const
+{
+    // Anonymous members are written through their container, at the level,
+    // for the same reason as in clone().
+    assert(0);
+    writer.fail();
+}
+
+void TSymbolTableLevel::serialize(TSymbolWriter& writer) const
+{
+    // Count the anonymous containers, so reading can restart numbering them
+    // where clone() would have.
+    std::vector<bool> containerWritten(anonId, false);
+    int numContainers = 0;
+    tLevel::const_iterator iter;
+    for (iter = level.begin(); iter != level.end(); ++iter) {
+        const TAnonMember* anon = iter->second->getAsAnonMember();
+        if (anon && ! containerWritten[anon->getAnonId()]) {
+            containerWritten[anon->getAnonId()] = true;
+            ++numContainers;
+        }
+    }
+    writer.writeInt(anonId - numContainers);
+    writer.writeBool(thisLevel);
+
+    containerWritten.assign(anonId, false);
+    for (iter = level.begin(); iter != level.end(); ++iter) {
+        const TAnonMember* anon = iter->second->getAsAnonMember();
+        if (anon) {
+            if (! containerWritten[anon->getAnonId()]) {
+                writer.writeInt(EssAnonContainer);
+                anon->getAnonContainer().serialize(writer);
+                containerWritten[anon->getAnonId()] = true;
+            }
+        } else if (iter->second->getAsFunction()) {
+            writer.writeInt(EssFunction);
+            iter->second->serialize(writer);
+        } else {
+            writer.writeInt(EssVariable);
+            iter->second->serialize(writer);
+        }
+    }
+    writer.writeInt(EssEndOfLevel);
+}
+
+TSymbolTableLevel* TSymbolTableLevel::deserialize(TSymbolReader& reader)
+{
+    TSymbolTableLevel *symTableLevel = new TSymbolTableLevel();
+    symTableLevel->anonId = reader.readInt();
+    symTableLevel->thisLevel = reader.readBool();
+
+    for (;;) {
+        int tag = reader.readInt();
+        if (tag == EssEndOfLevel || reader.hasFailed())
+            break;
+
+        TSymbol* symbol = nullptr;
+        switch (tag) {
+        case EssVariable:
+            symbol = TVariable::deserialize(reader);
+            break;
+        case EssFunction:
+            symbol = TFunction::deserialize(reader);
+            break;
+        case EssAnonContainer:
+            symbol = TVariable::deserialize(reader);
+            if (symbol != nullptr)
+                symbol->changeName(NewPoolTString(""));
+            break;
+        default:
+            reader.fail();
+            break;
+        }
+
+        if (symbol == nullptr || reader.hasFailed() || ! symTableLevel->insert(*symbol, false)) {
+            delete symbol;
+            reader.fail();
+        }
+    }
+
+    if (reader.hasFailed()) {
+        delete symTableLevel;
+        return nullptr;
+    }
+
+    return symTableLevel;
+}
+
+void TSymbolTable::serialize(TSymbolWriter& writer) const
+{
+    writer.writeInt(uniqueId);
+    writer.writeBool(noBuiltInRedeclarations);
+    writer.writeBool(separateNameSpaces);
+    writer.writeInt((int)(table.size() - adoptedLevels));
+    for (unsigned int i = adoptedLevels; i < table.size(); ++i)
+        table[i]->serialize(writer);
+}
+
+bool TSymbolTable::deserialize(TSymbolReader& reader)
+{
+    uniqueId = reader.readInt();
+    noBuiltInRedeclarations = reader.readBool();
+    separateNameSpaces = reader.readBool();
+    int numLevels = reader.readInt();
+    for (int i = 0; i < numLevels && ! reader.hasFailed(); ++i) {
+        TSymbolTableLevel* level = TSymbolTableLevel::deserialize(reader);
+        if (level == nullptr)
+            return false;
+        table.push_back(level);
+    }
+
+    return ! reader.hasFailed();
+}
+
 } // end namespace glslang
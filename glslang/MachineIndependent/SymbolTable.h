@@ -70,6 +70,49 @@
 
 namespace glslang {
 
+//
+// Byte streams for the binary form of the shared built-in symbol tables,
+// letting a process load its built-ins instead of parsing them again.
+// The form is only meaningful to the same build of glslang that wrote it.
+//
+class TSymbolWriter {
+public:
+    TSymbolWriter() : failed(false) { }
+
+    void write(const void* bytes, size_t size);
+    void writeInt(int i) { write(&i, sizeof(i)); }
+    void writeBool(bool b) { writeInt(b ? 1 : 0); }
+    void writeString(const char* s);  // nullptr is written distinctly from ""
+
+    // Note something that has no binary form; the whole stream is then unusable.
+    void fail() { failed = true; }
+    bool hasFailed() const { return failed; }
+    const std::vector<char>& getData() const { return data; }
+
+protected:
+    std::vector<char> data;
+    bool failed;
+};
+
+class TSymbolReader {
+public:
+    TSymbolReader(const char* data, size_t size) : current(data), end(data + size), failed(false) { }
+
+    bool read(void* bytes, size_t size);
+    int readInt();
+    bool readBool() { return readInt() != 0; }
+    TString* readString();            // returns nullptr for a written nullptr, and on failure
+
+    void fail() { failed = true; }
+    bool hasFailed() const { return failed; }
+    bool atEnd() const { return current == end; }
+
+protected:
+    const char* current;
+    const char* end;
+    bool failed;
+};
+
 //
 // Symbol base class.  (Can build functions or variables out of these...)
 //
@@ -115,6 +158,7 @@ public:
     virtual int getNumExtensions() const { return numExtensions; }
     virtual const char** getExtensions() const { return extensions; }
     virtual void dump(TInfoSink &infoSink) const = 0;
+    virtual void serialize(TSymbolWriter&) const = 0;
 
     virtual bool isReadOnly() const { return ! writable; }
     virtual void makeReadOnly() { writable = false; }
@@ -123,6 +167,9 @@ protected:
     explicit TSymbol(const TSymbol&);
     TSymbol& operator=(const TSymbol&);
 
+    void serializeExtensions(TSymbolWriter&) const;
+    bool deserializeExtensions(TSymbolReader&);
+
     const TString *name;
     unsigned int uniqueId;      // For cross-scope comparing during code generation
 
@@ -170,8 +217,15 @@ public:
     virtual TIntermTyped* getConstSubtree() const { return constSubtree; }
     virtual void setAnonId(int i) { anonId = i; }
     virtual int getAnonId() const { return anonId; }
+    virtual void makeReadOnly()
+    {
+        type.unshareQualifiers();
+        TSymbol::makeReadOnly();
+    }
 
     virtual void dump(TInfoSink &infoSink) const;
+    virtual void serialize(TSymbolWriter&) const;
+    static TVariable* deserialize(TSymbolReader&);
 
 protected:
     explicit TVariable(const TVariable&);
@@ -207,7 +261,11 @@ struct TParameter {
         type = param.type->clone();
         defaultValue = param.defaultValue;
     }
-    TBuiltInVariable getDeclaredBuiltIn() const { return type->getQualifier().declaredBuiltIn; }
+    TBuiltInVariable getDeclaredBuiltIn() const
+    {
+        const TType& readType = *type;  // reading through a non-const type would copy its qualifier
+        return readType.getQualifier().declaredBuiltIn;
+    }
 };
 
 //
@@ -282,6 +340,13 @@ public:
     virtual bool hasImplicitThis() const { return implicitThis; }
     virtual void setIllegalImplicitThis() { assert(writable); illegalImplicitThis = true; }
     virtual bool hasIllegalImplicitThis() const { return illegalImplicitThis; }
+    virtual void makeReadOnly() override
+    {
+        returnType.unshareQualifiers();
+        for (unsigned int i = 0; i < parameters.size(); ++i)
+            parameters[i].type->unshareQualifiers();
+        TSymbol::makeReadOnly();
+    }
 
     // Return total number of parameters
     virtual int getParamCount() const { return static_cast<int>(parameters.size()); }
@@ -294,6 +359,8 @@ public:
     virtual const TParameter& operator[](int i) const { return parameters[i]; }
 
     virtual void dump(TInfoSink &infoSink) const override;
+    virtual void serialize(TSymbolWriter&) const override;
+    static TFunction* deserialize(TSymbolReader&);
 
 protected:
     explicit TFunction(const TFunction&);
@@ -346,7 +413,13 @@ public:
     }
 
     virtual int getAnonId() const { return anonId; }
+    virtual void makeReadOnly()
+    {
+        (*anonContainer.getType().getStruct())[memberNumber].type->unshareQualifiers();
+        TSymbol::makeReadOnly();
+    }
     virtual void dump(TInfoSink &infoSink) const;
+    virtual void serialize(TSymbolWriter&) const;
 
 protected:
     explicit TAnonMember(const TAnonMember&);
@@ -389,7 +462,8 @@ public:
                     return false;
 
                 // insert, and whatever happens is okay
-                level.insert(tLevelPair(insertName, &symbol));
+                if (level.insert(tLevelPair(insertName, &symbol)).second)
+                    insertOverload(*symbol.getAsFunction());
 
                 return true;
             } else
@@ -430,56 +504,35 @@ public:
             return (*it).second;
     }
 
-    void findFunctionNameList(const TString& name, TVector<const TFunction*>& list)
+    // Add all the overloads of the given non-function-style name to the list,
+    // in mangled-name order.
+    void findFunctionNameList(const TString& name, TVector<const TFunction*>& list) const
     {
-        size_t parenAt = name.find_first_of('(');
-        TString base(name, 0, parenAt + 1);
-
-        tLevel::const_iterator begin = level.lower_bound(base);
-        base[parenAt] = ')';  // assume ')' is lexically after '('
-        tLevel::const_iterator end = level.upper_bound(base);
-        for (tLevel::const_iterator it = begin; it != end; ++it)
-            list.push_back(it->second->getAsFunction());
+        tOverloads::const_iterator it = overloads.find(name);
+        if (it != overloads.end())
+            list.insert(list.end(), it->second.begin(), it->second.end());
     }
 
     // See if there is already a function in the table having the given non-function-style name.
     bool hasFunctionName(const TString& name) const
     {
-        tLevel::const_iterator candidate = level.lower_bound(name);
-        if (candidate != level.end()) {
-            const TString& candidateName = (*candidate).first;
-            TString::size_type parenAt = candidateName.find_first_of('(');
-            if (parenAt != candidateName.npos && candidateName.compare(0, parenAt, name) == 0)
-
-                return true;
-        }
-
-        return false;
+        return overloads.find(name) != overloads.end();
     }
 
     // See if there is a variable at this level having the given non-function-style name.
     // Return true if name is found, and set variable to true if the name was a variable.
     bool findFunctionVariableName(const TString& name, bool& variable) const
     {
-        tLevel::const_iterator candidate = level.lower_bound(name);
-        if (candidate != level.end()) {
-            const TString& candidateName = (*candidate).first;
-            TString::size_type parenAt = candidateName.find_first_of('(');
-            if (parenAt == candidateName.npos) {
-                // not a mangled name
-                if (candidateName == name) {
-                    // found a variable name match
-                    variable = true;
-                    return true;
-                }
-            } else {
-                // a mangled name
-                if (candidateName.compare(0, parenAt, name) == 0) {
-                    // found a function name match
-                    variable = false;
-                    return true;
-                }
-            }
+        if (hasFunctionName(name)) {
+            // found a function name match
+            variable = false;
+            return true;
+        }
+
+        if (level.find(name) != level.end()) {
+            // found a variable name match
+            variable = true;
+            return true;
         }
 
         return false;
@@ -516,6 +569,8 @@ public:
     void setFunctionExtensions(const char* name, int num, const char* const extensions[]);
     void dump(TInfoSink &infoSink) const;
     TSymbolTableLevel* clone() const;
+    void serialize(TSymbolWriter&) const;
+    static TSymbolTableLevel* deserialize(TSymbolReader&);
     void readOnly();
 
     void setThisLevel() { thisLevel = true; }
@@ -525,11 +580,18 @@ protected:
     explicit TSymbolTableLevel(TSymbolTableLevel&);
     TSymbolTableLevel& operator=(TSymbolTableLevel&);
 
+    void insertOverload(TFunction&);
+
     typedef std::map<TString, TSymbol*, std::less<TString>, pool_allocator<std::pair<const TString, TSymbol*> > > tLevel;
     typedef const tLevel::value_type tLevelPair;
     typedef std::pair<tLevel::iterator, bool> tInsertResult;
 
+    // All the functions in 'level' having the same non-function-style name,
+    // so overload resolution need not search through mangled names
+    typedef TUnorderedMap<TString, TVector<TFunction*> > tOverloads;
+
     tLevel level;  // named mappings
+    tOverloads overloads;
     TPrecisionQualifier *defaultPrecision;
     int anonId;
     bool thisLevel;  // True if this level of the symbol table is a structure scope containing member function
@@ -757,11 +819,13 @@ public:
 
     void findFunctionNameList(const TString& name, TVector<const TFunction*>& list, bool& builtIn)
     {
+        const TString base(name, 0, name.find_first_of('('));
+
         // For user levels, return the set found in the first scope with a match
         builtIn = false;
         int level = currentLevel();
         do {
-            table[level]->findFunctionNameList(name, list);
+            table[level]->findFunctionNameList(base, list);
             --level;
         } while (list.empty() && level >= globalLevel);
 
@@ -771,7 +835,7 @@ public:
         // Gather across all built-in levels; they don't hide each other
         builtIn = true;
         do {
-            table[level]->findFunctionNameList(name, list);
+            table[level]->findFunctionNameList(base, list);
             --level;
         } while (level >= 0);
     }
@@ -799,6 +863,10 @@ public:
     void dump(TInfoSink &infoSink) const;
     void copyTable(const TSymbolTable& copyOf);
 
+    // Like copyTable(), these only cover the levels that were not adopted.
+    void serialize(TSymbolWriter&) const;
+    bool deserialize(TSymbolReader&);
+
     void setPreviousDefaultPrecisions(TPrecisionQualifier *p) { table[currentLevel()]->setPreviousDefaultPrecisions(p); }
 
     void readOnly()
@@ -244,8 +244,10 @@ void TIntermediate::mergeLinkerObjects(TInfoSink& infoSink, TIntermSequence& lin
                     symbol->setConstArray(unitSymbol->getConstArray());
 
                 // Similarly for binding
-                if (! symbol->getQualifier().hasBinding() && unitSymbol->getQualifier().hasBinding())
-                    symbol->getQualifier().layoutBinding = unitSymbol->getQualifier().layoutBinding;
+                if (! symbol->getQualifier().hasBinding() && unitSymbol->getQualifier().hasBinding()) {
+                    const unsigned int binding = unitSymbol->getQualifier().layoutBinding;
+                    symbol->getWritableType().editQualifier([binding](TQualifier& q) { q.layoutBinding = binding; });
+                }
 
                 // Update implicit array sizes
                 mergeImplicitArraySizes(symbol->getWritableType(), unitSymbol->getType());
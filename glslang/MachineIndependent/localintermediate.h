@@ -293,6 +293,9 @@ public:
     TIntermConstantUnion* addConstantUnion(bool, const TSourceLoc&, bool literal = false) const;
     TIntermConstantUnion* addConstantUnion(double, TBasicType, const TSourceLoc&, bool literal = false) const;
     TIntermConstantUnion* addConstantUnion(const TString*, const TSourceLoc&, bool literal = false) const;
+    TConstUnionArray internConstArray(const TConstUnionArray&) const;
+    TConstUnionArray internConstant(const TConstUnion&) const;
+    TIntermTyped* internConstants(TIntermTyped*) const;
     TIntermTyped* promoteConstantUnion(TBasicType, TIntermConstantUnion*) const;
     bool parseConstTree(TIntermNode*, TConstUnionArray, TOperator, const TType&, bool singleConstantParam = false);
     TIntermLoop* addLoop(TIntermNode*, TIntermTyped*, TIntermTyped*, bool testFirst, const TSourceLoc&, TLoopControl = ELoopControlNone);
@@ -548,6 +551,7 @@ protected:
     std::vector<TXfbBuffer> xfbBuffers;     // all the data we need to track per xfb buffer
     std::unordered_set<int> usedConstantId; // specialization constant ids used
     std::set<TString> semanticNameSet;
+    mutable std::unordered_multimap<size_t, TConstUnionArray> constArrays; // folded and literal constants, see internConstArray()
 
     EShTextureSamplerTransformMode textureSamplerTransformMode;
 
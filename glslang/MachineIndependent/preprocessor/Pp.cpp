@@ -239,6 +239,8 @@ int TPpContext::CPPelse(int matchelse, TPpToken* ppToken)
             continue;
 
         int nextAtom = atomStrings.getAtom(ppToken->name);
+        if (depth == 0 && (nextAtom == PpAtomElse || nextAtom == PpAtomElif))
+            noteIncludeBranch();
         if (nextAtom == PpAtomIf || nextAtom == PpAtomIfdef || nextAtom == PpAtomIfndef) {
             depth++;
             ifdepth++;
@@ -568,6 +570,8 @@ int TPpContext::CPPifdef(int defined, TPpToken* ppToken)
             parseContext.ppError(ppToken->loc, "must be followed by macro name", "#ifndef", "");
     } else {
         MacroSymbol* macro = lookupMacroDef(atomStrings.getAtom(ppToken->name));
+        if (! defined)
+            noteIncludeIfndef(atomStrings.getAddAtom(ppToken->name));
         token = scanToken(ppToken);
         if (token != '\n') {
             parseContext.ppError(ppToken->loc, "unexpected tokens following #ifdef directive - expected a newline", "#ifdef", "");
@@ -616,6 +620,19 @@ int TPpContext::CPPinclude(TPpToken* ppToken)
 
     // Process well-formed directive
 
+    // A header that has been included with #pragma once, or that was all inside an
+    // include guard that is now defined, adds nothing.  When it was asked for the
+    // same way before (the includer gets the same arguments and directories), skip
+    // it without asking the includer for it again.
+    std::string includeKey = (startWithLocalSearch ? "\"" : "<") + filename;
+    for (const auto include : includeStack) {
+        includeKey += '\0';
+        includeKey += include->headerName;
+    }
+    const auto resolved = resolvedIncludes.find(includeKey);
+    if (resolved != resolvedIncludes.end() && isIncludeSkipped(resolved->second))
+        return token;
+
     // Find the inclusion, first look in "Local" ("") paths, if requested,
     // otherwise, only search the "System" (<>) paths.
     TShader::Includer::IncludeResult* res = nullptr;
@@ -628,7 +645,11 @@ int TPpContext::CPPinclude(TPpToken* ppToken)
 
     // Process the results
     if (res != nullptr && !res->headerName.empty()) {
-        if (res->headerData != nullptr && res->headerLength > 0) {
+        resolvedIncludes[includeKey] = res->headerName;
+        if (isIncludeSkipped(res->headerName)) {
+            // reached another way, but still adds nothing
+            includer.releaseInclude(res);
+        } else if (res->headerData != nullptr && res->headerLength > 0) {
             // path for processing one or more tokens from an included header, hand off 'res'
             const bool forNextLine = parseContext.lineDirectiveShouldSetNextLine();
             std::ostringstream prologue;
@@ -655,6 +676,67 @@ int TPpContext::CPPinclude(TPpToken* ppToken)
     return token;
 }
 
+// Call for each token of the header being included, other than newlines.
+void TPpContext::noteIncludeToken()
+{
+    TGuardScan& scan = guardScans.back();
+    if (ifdepth > scan.outsideDepth)
+        return;
+
+    if (scan.state == EGuardStart && scan.tokens < 3)
+        ++scan.tokens;
+    else
+        scan.state = EGuardNone;
+}
+
+// Call for each #ifndef, with ifdepth already counting it.
+void TPpContext::noteIncludeIfndef(int atom)
+{
+    if (guardScans.empty())
+        return;
+
+    TGuardScan& scan = guardScans.back();
+    if (scan.state == EGuardStart && scan.tokens == 3 && ifdepth == scan.outsideDepth + 1) {
+        scan.state = EGuardOpen;
+        scan.atom = atom;
+    }
+}
+
+// Call for each #else or #elif, with ifdepth counting the #if it belongs to.
+void TPpContext::noteIncludeBranch()
+{
+    if (! guardScans.empty() && guardScans.back().state == EGuardOpen &&
+        ifdepth == guardScans.back().outsideDepth + 1)
+        guardScans.back().state = EGuardNone;
+}
+
+void TPpContext::noteIncludePragmaOnce()
+{
+    if (! includeStack.empty())
+        includeGuards[includeStack.back()->headerName].once = true;
+}
+
+// Call when done with the header being included.
+void TPpContext::noteIncludeEnd(const std::string& headerName)
+{
+    const TGuardScan& scan = guardScans.back();
+    if (scan.state == EGuardOpen && ifdepth == scan.outsideDepth)
+        includeGuards[headerName].atom = scan.atom;
+}
+
+// Whether including the header would add nothing now.
+bool TPpContext::isIncludeSkipped(const std::string& headerName)
+{
+    const auto guard = includeGuards.find(headerName);
+    if (guard == includeGuards.end())
+        return false;
+    if (guard->second.once)
+        return true;
+
+    MacroSymbol* macro = guard->second.atom != 0 ? lookupMacroDef(guard->second.atom) : nullptr;
+    return macro != nullptr && ! macro->undef;
+}
+
 // Handle #line
 int TPpContext::CPPline(TPpToken* ppToken)
 {
@@ -780,8 +862,11 @@ int TPpContext::CPPpragma(TPpToken* ppToken)
 
     if (token == EndOfInput)
         parseContext.ppError(loc, "directive must end with a newline", "#pragma", "");
-    else
+    else {
+        if (tokens.size() == 1 && tokens[0] == "once")
+            noteIncludePragmaOnce();
         parseContext.handlePragma(loc, tokens);
+    }
 
     return token;
 }
@@ -891,6 +976,7 @@ int TPpContext::readCPPline(TPpToken* ppToken)
             elsetracker[elseSeen] = true;
             if (! ifdepth)
                 parseContext.ppError(ppToken->loc, "mismatched statements", "#else", "");
+            noteIncludeBranch();
             token = extraTokenCheck(PpAtomElse, ppToken, scanToken(ppToken));
             token = CPPelse(0, ppToken);
             break;
@@ -899,6 +985,7 @@ int TPpContext::readCPPline(TPpToken* ppToken)
                 parseContext.ppError(ppToken->loc, "mismatched statements", "#elif", "");
             if (elseSeen[elsetracker])
                 parseContext.ppError(ppToken->loc, "#elif after #else", "#elif", "");
+            noteIncludeBranch();
             // this token is really a dont care, but we still need to eat the tokens
             token = scanToken(ppToken);
             while (token != '\n' && token != EndOfInput)
@@ -85,7 +85,8 @@ namespace glslang {
 TPpContext::TPpContext(TParseContextBase& pc, const std::string& rootFileName, TShader::Includer& inclr) :
     preamble(0), strings(0), previous_token('\n'), parseContext(pc), includer(inclr), inComment(false),
     rootFileName(rootFileName),
-    currentSourceFile(rootFileName)
+    currentSourceFile(rootFileName),
+    scannedSource(nullptr), sourceStrings(nullptr), sourceLengths(nullptr), firstSourceString(0), numSourceStrings(0)
 {
     ifdepth = 0;
     for (elsetracker = 0; elsetracker < maxIfNesting; elsetracker++)
@@ -106,7 +107,19 @@ void TPpContext::setInput(TInputScanner& input, bool versionWillBeError)
 {
     assert(inputStack.size() == 0);
 
-    pushInput(new tStringInput(this, input));
+    if (scannedSource != nullptr) {
+        std::shared_ptr<const TScannedText> scanned;
+        const bool record = findScannedSource(*scannedSource, &sourceStrings[firstSourceString],
+                                              &sourceLengths[firstSourceString], numSourceStrings, scanned);
+        tCachedStringInput* cachedInput = new tScannedSourceInput(this, input, sourceStrings, sourceLengths,
+                                                                  firstSourceString, numSourceStrings, *scannedSource);
+        if (scanned != nullptr)
+            cachedInput->setScanned(std::move(scanned));
+        else if (record)
+            cachedInput->startRecording();
+        pushInput(cachedInput);
+    } else
+        pushInput(new tStringInput(this, input));
 
     errorOnVersion = versionWillBeError;
     versionSeen = false;
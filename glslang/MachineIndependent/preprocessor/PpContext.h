@@ -78,8 +78,10 @@ NVIDIA HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef PPCONTEXT_H
 #define PPCONTEXT_H
 
-#include <stack>
+#include <cstring>
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "../ParseHelper.h"
 
@@ -92,7 +94,7 @@ namespace glslang {
 
 class TPpToken {
 public:
-    TPpToken() : space(false), i64val(0)
+    TPpToken() : space(false), i64val(0), atom(0)
     {
         loc.init();
         name[0] = 0;
@@ -117,6 +119,7 @@ public:
     };
 
     char   name[MaxTokenLength + 1];
+    int    atom;  // for an identifier returned by tokenize(), the atom interning its name
 };
 
 class TStringAtomMap {
@@ -235,17 +238,27 @@ public:
 
         void putToken(int token, TPpToken* ppToken);
         int getToken(TParseContextBase&, TPpToken*);
-        bool atEnd() { return current >= data.size(); }
+        bool atEnd() { return current >= stream.size(); }
         bool peekTokenizedPasting(bool lastTokenPastes);
         bool peekUntokenizedPasting();
         void reset() { current = 0; }
 
     protected:
-        void putSubtoken(char);
-        int getSubtoken();
-        void ungetSubtoken();
-
-        TVector<unsigned char> data;
+        // A token as recorded, with its value already decoded from its
+        // spelling, so playing it back is a copy instead of a re-scan.
+        struct Token {
+            int atom;
+            int nameStart;   // offset of the spelling in 'names', or -1 if it has none
+            int nameLength;
+            union {
+                int ival;
+                double dval;
+                long long i64val;
+            };
+        };
+
+        TVector<Token> stream;
+        TVector<char> names;  // spellings of all the tokens in 'stream'
         size_t current;
     };
 
@@ -271,6 +284,71 @@ public:
     }
     void addMacroDef(int atom, MacroSymbol& macroDef) { macroDefs[atom] = macroDef; }
 
+    // The tokens scanned from source strings, to be replayed wherever the same strings
+    // are scanned again, by any compile of the process, instead of scanning them again:
+    // the text of an included header (see SetIncludeCacheSize()), or the strings of the
+    // shaders sharing a TScannedSource.  Only scans depending on nothing but the text
+    // are kept, so each is found by where in the strings it started.  Read-only once
+    // recorded.
+    struct TScannedText {
+        struct Token {
+            int source;        // which of the strings
+            size_t scanStart;  // offset in it scan() started at
+            size_t scanEnd;    // ...and left off at
+            int atom;
+            bool space;
+            long long i64val;  // all of ival, dval, or i64val, whichever scan() set
+            int nameStart;     // into names, or -1 when scan() set no name
+            int locLine;       // lines from the start of the scan to the token
+            int locColumn;
+            int endLine;       // lines from the start of the scan to its end
+            int endColumn;
+        };
+
+        std::string name;                // for a header, its name as resolved by the includer
+        std::vector<std::string> texts;  // the strings scanned
+        std::vector<Token> tokens;       // in order of source and scanStart
+        std::vector<char> names;         // 0-terminated names of tokens
+
+        bool isFor(const char* const* strings, const size_t* lengths, int numStrings) const
+        {
+            if ((int)texts.size() != numStrings)
+                return false;
+            for (int s = 0; s < numStrings; ++s) {
+                if (texts[s].size() != lengths[s] || memcmp(texts[s].data(), strings[s], lengths[s]) != 0)
+                    return false;
+            }
+            return true;
+        }
+
+        size_t getBytes() const
+        {
+            size_t bytes = sizeof(*this) + name.size() + tokens.size() * sizeof(Token) + names.size();
+            for (const auto& text : texts)
+                bytes += sizeof(text) + text.size();
+            return bytes;
+        }
+    };
+
+    // Return false if the include cache is off, otherwise look up the scanned form
+    // of 'header', leaving nullptr in 'scanned' if it isn't there.
+    static bool findScannedHeader(const TShader::Includer::IncludeResult& header,
+                                  std::shared_ptr<const TScannedText>& scanned);
+    static void addScannedHeader(std::shared_ptr<TScannedText> scanned);
+
+    // Look up the scanned form of a shader's strings in 'source', leaving nullptr in
+    // 'scanned' if it isn't there.  Return true if it should be recorded, which
+    // is left to one compile at a time, until it adds what it recorded.
+    static bool findScannedSource(TScannedSource& source, const char* const* strings, const size_t* lengths,
+                                  int numStrings, std::shared_ptr<const TScannedText>& scanned);
+    static void addScannedSource(TScannedSource& source, std::shared_ptr<TScannedText> scanned);
+
+    // Replay the scans of the user's strings of the shader from 'source', or record them
+    // in it.  Call before setInput(), with the strings of its scanner, the user's from
+    // 'firstString' on.
+    void setScannedSource(TScannedSource* source, const char* const* strings, const size_t* lengths,
+                          int firstString, int numStrings);
+
 protected:
     TPpContext(TPpContext&);
     TPpContext& operator=(TPpContext&);
@@ -504,9 +582,60 @@ protected:
         TInputScanner* input;
     };
 
+    // A tStringInput that replays scans of some of its scanner's strings, 'numSources'
+    // of them from 'firstSource' on, from a TScannedText, or else records them into one.
+    class tCachedStringInput : public tStringInput {
+    public:
+        tCachedStringInput(TPpContext* pp, TInputScanner& i, const char* const* strings, const size_t* lengths,
+                           int firstSource, int numSources)
+            : tStringInput(pp, i), strings(strings), lengths(lengths), firstSource(firstSource), numSources(numSources) { }
+        virtual int scan(TPpToken*) override;
+
+        void setScanned(std::shared_ptr<const TScannedText> s) { scanned = std::move(s); }
+
+        // Start recording, keeping a copy of the strings, as they can be gone by the
+        // time the recording is taken.
+        void startRecording();
+
+        // Take what was recorded, with the strings it was recorded from, or nullptr
+        // if not recording.
+        std::shared_ptr<TScannedText> takeRecording() { return std::move(recording); }
+
+    protected:
+        const char* const* strings;  // all the scanner's strings
+        const size_t* lengths;
+        int firstSource;
+        int numSources;
+        std::shared_ptr<const TScannedText> scanned;
+        std::shared_ptr<TScannedText> recording;
+    };
+
+    // The shader's strings, replayed from or recorded into a TScannedSource.
+    class tScannedSourceInput : public tCachedStringInput {
+    public:
+        tScannedSourceInput(TPpContext* pp, TInputScanner& i, const char* const* strings, const size_t* lengths,
+                            int firstSource, int numSources, TScannedSource& source)
+            : tCachedStringInput(pp, i, strings, lengths, firstSource, numSources), source(source) { }
+
+        void notifyDeleted() override
+        {
+            std::shared_ptr<TScannedText> recorded = takeRecording();
+            if (recorded != nullptr)
+                addScannedSource(source, std::move(recorded));
+        }
+
+    protected:
+        tScannedSourceInput& operator=(const tScannedSourceInput&);
+
+        TScannedSource& source;
+    };
+
     // Holds a reference to included file data, as well as a
     // prologue and an epilogue string. This can be scanned using the tInput
     // interface and acts as a single source string.
+    //
+    // With the include cache on, the header's tokens are replayed from the cache,
+    // or recorded for it.
     class TokenizableIncludeFile : public tInput {
     public:
         // Copies prologue and epilogue. The includedFile must remain valid
@@ -522,7 +651,7 @@ protected:
               includedFile_(includedFile),
               scanner(3, strings, lengths, names, 0, 0, true),
               prevScanner(nullptr),
-              stringInput(pp, scanner)
+              stringInput(pp, scanner, strings, lengths, 1, 1)
         {
               strings[0] = prologue_.data();
               strings[1] = includedFile_->headerData;
@@ -538,10 +667,18 @@ protected:
               scanner.setFile(startLoc.name, 0);
               scanner.setFile(startLoc.name, 1);
               scanner.setFile(startLoc.name, 2);
+
+              std::shared_ptr<const TScannedText> scanned;
+              if (findScannedHeader(*includedFile_, scanned)) {
+                  if (scanned != nullptr)
+                      stringInput.setScanned(std::move(scanned));
+                  else
+                      stringInput.startRecording();
+              }
         }
 
         // tInput methods:
-        int scan(TPpToken* t) override { return stringInput.scan(t); }
+        int scan(TPpToken*) override;
         int getch() override { return stringInput.getch(); }
         void ungetch() override { stringInput.ungetch(); }
 
@@ -555,6 +692,11 @@ protected:
         void notifyDeleted() override
         {
             pp->parseContext.setScanner(prevScanner);
+            std::shared_ptr<TScannedText> recorded = stringInput.takeRecording();
+            if (recorded != nullptr && ! recorded->tokens.empty()) {
+                recorded->name = includedFile_->headerName;
+                addScannedHeader(std::move(recorded));
+            }
             pp->pop_include();
         }
 
@@ -584,8 +726,9 @@ protected:
         // The previous effective scanner before the scanner in this instance
         // has been activated.
         TInputScanner* prevScanner;
-        // Delegate object implementing the tInput interface.
-        tStringInput stringInput;
+        // Delegate object implementing the tInput interface, and replaying the
+        // header's tokens from the include cache, or recording them for it.
+        tCachedStringInput stringInput;
     };
 
     int ScanFromString(char* s);
@@ -596,27 +739,73 @@ protected:
     void push_include(TShader::Includer::IncludeResult* result)
     {
         currentSourceFile = result->headerName;
-        includeStack.push(result);
+        includeStack.push_back(result);
+        guardScans.push_back(TGuardScan(ifdepth));
     }
 
     void pop_include()
     {
-        TShader::Includer::IncludeResult* include = includeStack.top();
-        includeStack.pop();
+        TShader::Includer::IncludeResult* include = includeStack.back();
+        noteIncludeEnd(include->headerName);
+        includeStack.pop_back();
+        guardScans.pop_back();
         includer.releaseInclude(include);
         if (includeStack.empty()) {
             currentSourceFile = rootFileName;
         } else {
-            currentSourceFile = includeStack.top()->headerName;
+            currentSourceFile = includeStack.back()->headerName;
         }
     }
 
+    // Following the headers being included for an include guard: everything but
+    // their first three tokens, "#ifndef GUARD", being inside that #ifndef.
+    enum TGuardState {
+        EGuardStart,  // before the #ifndef
+        EGuardOpen,   // inside it, or after its #endif with nothing more yet
+        EGuardNone    // no include guard
+    };
+    struct TGuardScan {
+        explicit TGuardScan(int depth) : state(EGuardStart), outsideDepth(depth), tokens(0), atom(0) { }
+        TGuardState state;
+        int outsideDepth;  // ifdepth when the header was entered
+        int tokens;        // while EGuardStart, the tokens seen at outsideDepth
+        int atom;          // the guard's macro
+    };
+    void noteIncludeToken();
+    void noteIncludeIfndef(int atom);
+    void noteIncludeBranch();
+    void noteIncludePragmaOnce();
+    void noteIncludeEnd(const std::string& headerName);
+    bool isIncludeSkipped(const std::string& headerName);
+
+    // Headers that need not be included again, by resolved name.
+    struct TIncludeGuard {
+        TIncludeGuard() : once(false), atom(0) { }
+        bool once;  // had #pragma once
+        int atom;   // the macro that, when defined, leaves nothing of it, or 0
+    };
+    std::unordered_map<std::string, TIncludeGuard> includeGuards;
+    // The resolved names of #includes, by the header name asked for and the headers
+    // it was asked from, so skipping a header needs no call to the includer.
+    std::unordered_map<std::string, std::string> resolvedIncludes;
+
     bool inComment;
     std::string rootFileName;
-    std::stack<TShader::Includer::IncludeResult*> includeStack;
+    std::vector<TShader::Includer::IncludeResult*> includeStack;
+    std::vector<TGuardScan> guardScans;  // one for each of includeStack
     std::string currentSourceFile;
+
+    // For setInput(), from setScannedSource()
+    TScannedSource* scannedSource;
+    const char* const* sourceStrings;
+    const size_t* sourceLengths;
+    int firstSourceString;
+    int numSourceStrings;
 };
 
+// Empty the include cache, at process finalization.
+void FreeIncludeCache();
+
 } // end namespace glslang
 
 #endif  // PPCONTEXT_H
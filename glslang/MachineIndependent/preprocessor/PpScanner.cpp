@@ -80,8 +80,12 @@ NVIDIA HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#include <algorithm>
+#include <cctype>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#include <utility>
 
 #include "PpContext.h"
 #include "PpTokens.h"
@@ -903,6 +907,274 @@ int TPpContext::tStringInput::scan(TPpToken* ppToken)
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////// Replaying scanned tokens: //////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// The process-wide include cache, by resolved header name.  Entries are never
+// changed once added, so compiles share them through shared_ptr, outside the lock.
+std::mutex IncludeCacheMutex;
+std::unordered_map<std::string, std::shared_ptr<const TPpContext::TScannedText>> IncludeCache;
+size_t IncludeCacheLimit = 0;
+size_t IncludeCacheBytes = 0;
+
+// Whether a scan() of 'text' from 'start' up to 'end' can be replayed wherever the
+// text is scanned: everything it did has to follow from the text alone.  That
+// leaves out escaped newlines (checked against the version), character literals,
+// and numeric literals with suffixes, or followed by something a suffix could
+// start with (enabled by extensions).  Scans that made errors are left out too.
+bool IsReplayable(const char* text, size_t length, size_t start, size_t end, int atom, const TPpToken& ppToken)
+{
+    for (size_t c = start; c < std::min(end + 1, length); ++c) {
+        if (text[c] == '\\' || text[c] == '\'')
+            return false;
+    }
+
+    const char* spelling;
+    switch (atom) {
+    case PpAtomConstInt:
+    case PpAtomConstUint:
+        spelling = "0123456789abcdefABCDEFxXuU";
+        break;
+    case PpAtomConstFloat:
+        spelling = "0123456789.eE+-";
+        break;
+    case PpAtomConstInt64:
+    case PpAtomConstUint64:
+#ifdef AMD_EXTENSIONS
+    case PpAtomConstInt16:
+    case PpAtomConstUint16:
+#endif
+    case PpAtomConstDouble:
+    case PpAtomConstFloat16:
+        return false;
+    default:
+        return true;
+    }
+
+    if (ppToken.name[strspn(ppToken.name, spelling)] != '\0')
+        return false;
+    if (end < length && (isalnum((unsigned char)text[end]) || text[end] == '_' || text[end] == '.'))
+        return false;
+
+    return true;
+}
+
+} // end anonymous namespace
+
+bool TPpContext::findScannedHeader(const TShader::Includer::IncludeResult& header,
+                                   std::shared_ptr<const TScannedText>& scanned)
+{
+    std::shared_ptr<const TScannedText> entry;
+    {
+        std::lock_guard<std::mutex> lock(IncludeCacheMutex);
+        if (IncludeCacheLimit == 0)
+            return false;
+
+        const auto found = IncludeCache.find(header.headerName);
+        if (found != IncludeCache.end())
+            entry = found->second;
+    }
+
+    // Compare outside the lock, so other threads aren't held up by it.
+    if (entry != nullptr && entry->isFor(&header.headerData, &header.headerLength, 1))
+        scanned = std::move(entry);
+
+    return true;
+}
+
+void TPpContext::addScannedHeader(std::shared_ptr<TScannedText> scanned)
+{
+    std::lock_guard<std::mutex> lock(IncludeCacheMutex);
+
+    // A header that changed replaces what was scanned from it before.
+    auto& entry = IncludeCache[scanned->name];
+    if (entry != nullptr)
+        IncludeCacheBytes -= entry->getBytes();
+    if (IncludeCacheBytes + scanned->getBytes() > IncludeCacheLimit) {
+        IncludeCache.erase(scanned->name);
+        return;
+    }
+
+    IncludeCacheBytes += scanned->getBytes();
+    entry = std::move(scanned);
+}
+
+int TPpContext::TokenizableIncludeFile::scan(TPpToken* ppToken)
+{
+    // The prologue and epilogue are not part of the header.
+    const bool inHeader = scanner.getCurrentSource() == 1;
+    const int token = stringInput.scan(ppToken);
+    if (inHeader && token != '\n' && token != EndOfInput)
+        pp->noteIncludeToken();
+
+    return token;
+}
+
+//
+// Replay the next scan, if it was recorded, otherwise scan, and record the scan
+// if recording.
+//
+int TPpContext::tCachedStringInput::scan(TPpToken* ppToken)
+{
+    const int source = input->getCurrentSource() - firstSource;
+    if ((scanned == nullptr && recording == nullptr) || source < 0 || source >= numSources)
+        return tStringInput::scan(ppToken);
+
+    const size_t start = input->getCurrentChar();
+    const int startLine = input->getSourceLoc().line;
+
+    if (scanned != nullptr) {
+        const auto& tokens = scanned->tokens;
+        const auto token = std::lower_bound(tokens.begin(), tokens.end(), std::make_pair(source, start),
+            [](const TScannedText::Token& t, const std::pair<int, size_t>& at) {
+                return t.source < at.first || (t.source == at.first && t.scanStart < at.second);
+            });
+        if (token == tokens.end() || token->source != source || token->scanStart != start)
+            return tStringInput::scan(ppToken);
+
+        ppToken->i64val = token->i64val;
+        ppToken->space = token->space;
+        ppToken->loc = pp->parseContext.getCurrentLoc();
+        ppToken->loc.line += token->locLine;
+        ppToken->loc.column = token->locColumn;
+        if (token->nameStart >= 0)
+            strcpy(ppToken->name, &scanned->names[token->nameStart]);
+        input->skipTo(token->scanEnd, token->endLine, token->endColumn);
+
+        return token->atom;
+    }
+
+    const int numErrors = pp->parseContext.getNumErrors();
+    const int atom = tStringInput::scan(ppToken);
+
+    // Only what ends within the string it started in is kept, in order, as what
+    // follows a string can differ.
+    const size_t end = input->getCurrentChar();
+    if (atom == EndOfInput || input->getCurrentSource() - firstSource != source ||
+        pp->parseContext.getNumErrors() != numErrors ||
+        (! recording->tokens.empty() && (recording->tokens.back().source > source ||
+                                          (recording->tokens.back().source == source &&
+                                           recording->tokens.back().scanStart >= start))) ||
+        ! IsReplayable(strings[firstSource + source], lengths[firstSource + source], start, end, atom, *ppToken))
+        return atom;
+
+    TScannedText::Token token;
+    token.source = source;
+    token.scanStart = start;
+    token.scanEnd = end;
+    token.atom = atom;
+    token.space = ppToken->space;
+    token.i64val = ppToken->i64val;
+    token.nameStart = -1;
+    if (atom == PpAtomIdentifier || atom == PpAtomConstString ||
+        atom == PpAtomConstInt || atom == PpAtomConstUint || atom == PpAtomConstFloat) {
+        token.nameStart = (int)recording->names.size();
+        recording->names.insert(recording->names.end(), ppToken->name, ppToken->name + strlen(ppToken->name) + 1);
+    }
+    token.locLine = ppToken->loc.line - startLine;
+    token.locColumn = ppToken->loc.column;
+    token.endLine = input->getSourceLoc().line - startLine;
+    token.endColumn = input->getSourceLoc().column;
+    recording->tokens.push_back(token);
+
+    return atom;
+}
+
+void TPpContext::tCachedStringInput::startRecording()
+{
+    recording = std::make_shared<TScannedText>();
+    for (int s = firstSource; s < firstSource + numSources; ++s)
+        recording->texts.push_back(std::string(strings[s], lengths[s]));
+}
+
+//
+// The shader strings of a TScannedSource.
+//
+// TODO: share the preprocessing too, up to the first directive whose outcome
+// depends on the preamble: record the macro table and #if stack there, and have
+// each permutation continue from that point instead of from the first token.
+//
+struct TScannedSource::TData {
+    TData() : recording(false) { }
+
+    std::mutex mutex;
+    std::shared_ptr<const TPpContext::TScannedText> scanned;
+    bool recording;  // by some compile, now
+};
+
+TScannedSource::TScannedSource() : data(new TData) { }
+
+TScannedSource::~TScannedSource()
+{
+    delete data;
+}
+
+bool TPpContext::findScannedSource(TScannedSource& source, const char* const* strings, const size_t* lengths,
+                                   int numStrings, std::shared_ptr<const TScannedText>& scanned)
+{
+    std::shared_ptr<const TScannedText> entry;
+    {
+        std::lock_guard<std::mutex> lock(source.data->mutex);
+        entry = source.data->scanned;
+    }
+
+    // Compare outside the lock, so other threads aren't held up by it.
+    if (entry != nullptr && entry->isFor(strings, lengths, numStrings)) {
+        scanned = std::move(entry);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(source.data->mutex);
+    if (source.data->recording)
+        return false;
+
+    source.data->recording = true;
+
+    return true;
+}
+
+void TPpContext::addScannedSource(TScannedSource& source, std::shared_ptr<TScannedText> scanned)
+{
+    std::lock_guard<std::mutex> lock(source.data->mutex);
+    source.data->recording = false;
+
+    // Strings that changed replace what was scanned from them before.
+    if (! scanned->tokens.empty())
+        source.data->scanned = std::move(scanned);
+}
+
+void TPpContext::setScannedSource(TScannedSource* source, const char* const* strings, const size_t* lengths,
+                                  int firstString, int numStrings)
+{
+    scannedSource = source;
+    sourceStrings = strings;
+    sourceLengths = lengths;
+    firstSourceString = firstString;
+    numSourceStrings = numStrings;
+}
+
+void SetIncludeCacheSize(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(IncludeCacheMutex);
+    IncludeCacheLimit = maxBytes;
+
+    // Make room by dropping whole headers, as they come.
+    for (auto entry = IncludeCache.begin(); entry != IncludeCache.end() && IncludeCacheBytes > IncludeCacheLimit; ) {
+        IncludeCacheBytes -= entry->second->getBytes();
+        entry = IncludeCache.erase(entry);
+    }
+}
+
+void FreeIncludeCache()
+{
+    std::lock_guard<std::mutex> lock(IncludeCacheMutex);
+    IncludeCache.clear();
+    IncludeCacheBytes = 0;
+}
+
 //
 // The main functional entry point into the preprocessor, which will
 // scan the source strings to figure out and return the next processing token.
@@ -945,6 +1217,11 @@ int TPpContext::tokenize(TPpToken& ppToken)
 
         switch (token) {
         case PpAtomIdentifier:
+            if (ppToken.name[0] == '\0')
+                continue;
+            // Intern it, so later stages can tell identifiers apart by atom.
+            ppToken.atom = atomStrings.getAddAtom(ppToken.name);
+            break;
         case PpAtomConstInt:
         case PpAtomConstUint:
         case PpAtomConstFloat:
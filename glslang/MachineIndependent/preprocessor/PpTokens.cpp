@@ -95,48 +95,85 @@ NVIDIA HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "PpContext.h"
 #include "PpTokens.h"
 
-namespace glslang {
+namespace {
 
-// push onto back of stream
-void TPpContext::TokenStream::putSubtoken(char subtoken)
+// Decode the value of a numeric token from its spelling.
+void DecodeValue(int atom, const char* name, int len, long long& i64val, int& ival, double& dval)
 {
-    data.push_back(static_cast<unsigned char>(subtoken));
-}
+    using namespace glslang;
 
-// get the next token in stream
-int TPpContext::TokenStream::getSubtoken()
-{
-    if (current < data.size())
-        return data[current++];
-    else
-        return EndOfInput;
+    switch (atom) {
+    case PpAtomConstFloat:
+    case PpAtomConstDouble:
+#ifdef AMD_EXTENSIONS
+    case PpAtomConstFloat16:
+#endif
+        dval = atof(name);
+        break;
+    case PpAtomConstInt:
+#ifdef AMD_EXTENSIONS
+    case PpAtomConstInt16:
+#endif
+        if (len > 0 && name[0] == '0') {
+            if (len > 1 && (name[1] == 'x' || name[1] == 'X'))
+                ival = (int)strtol(name, 0, 16);
+            else
+                ival = (int)strtol(name, 0, 8);
+        } else
+            ival = atoi(name);
+        break;
+    case PpAtomConstUint:
+#ifdef AMD_EXTENSIONS
+    case PpAtomConstUint16:
+#endif
+        if (len > 0 && name[0] == '0') {
+            if (len > 1 && (name[1] == 'x' || name[1] == 'X'))
+                ival = (int)strtoul(name, 0, 16);
+            else
+                ival = (int)strtoul(name, 0, 8);
+        } else
+            ival = (int)strtoul(name, 0, 10);
+        break;
+    case PpAtomConstInt64:
+        if (len > 0 && name[0] == '0') {
+            if (len > 1 && (name[1] == 'x' || name[1] == 'X'))
+                i64val = strtoll(name, nullptr, 16);
+            else
+                i64val = strtoll(name, nullptr, 8);
+        } else
+            i64val = atoll(name);
+        break;
+    case PpAtomConstUint64:
+        if (len > 0 && name[0] == '0') {
+            if (len > 1 && (name[1] == 'x' || name[1] == 'X'))
+                i64val = (long long)strtoull(name, nullptr, 16);
+            else
+                i64val = (long long)strtoull(name, nullptr, 8);
+        } else
+            i64val = (long long)strtoull(name, 0, 10);
+        break;
+    default:
+        break;
+    }
 }
 
-// back up one position in the stream
-void TPpContext::TokenStream::ungetSubtoken()
-{
-    if (current > 0)
-        --current;
-}
+} // end anonymous namespace
+
+namespace glslang {
 
 // Add a complete token (including backing string) to the end of a list
 // for later playback.
-void TPpContext::TokenStream::putToken(int token, TPpToken* ppToken)
+void TPpContext::TokenStream::putToken(int atom, TPpToken* ppToken)
 {
-    const char* s;
-    char* str = NULL;
-
-    assert((token & ~0xff) == 0);
-    putSubtoken(static_cast<char>(token));
+    Token token;
+    token.atom = atom;
+    token.nameStart = -1;
+    token.nameLength = 0;
+    token.i64val = 0;
 
-    switch (token) {
+    switch (atom) {
     case PpAtomIdentifier:
     case PpAtomConstString:
-        s = ppToken->name;
-        while (*s)
-            putSubtoken(*s++);
-        putSubtoken(0);
-        break;
     case PpAtomConstInt:
     case PpAtomConstUint:
     case PpAtomConstInt64:
@@ -150,126 +187,68 @@ void TPpContext::TokenStream::putToken(int token, TPpToken* ppToken)
 #ifdef AMD_EXTENSIONS
     case PpAtomConstFloat16:
 #endif
-        str = ppToken->name;
-        while (*str) {
-            putSubtoken(*str);
-            str++;
-        }
-        putSubtoken(0);
+        token.nameStart = (int)names.size();
+        token.nameLength = (int)strlen(ppToken->name);
+        names.insert(names.end(), ppToken->name, ppToken->name + token.nameLength);
+        DecodeValue(atom, ppToken->name, token.nameLength, token.i64val, token.ival, token.dval);
         break;
     default:
         break;
     }
+
+    stream.push_back(token);
 }
 
 // Read the next token from a token stream.
 // (Not the source stream, but a stream used to hold a tokenized macro).
 int TPpContext::TokenStream::getToken(TParseContextBase& parseContext, TPpToken *ppToken)
 {
-    int len;
-    int ch;
-
-    int subtoken = getSubtoken();
     ppToken->loc = parseContext.getCurrentLoc();
-    switch (subtoken) {
-    case '#':
-        // Check for ##, unless the current # is the last character
-        if (current < data.size()) {
-            if (getSubtoken() == '#') {
-                parseContext.requireProfile(ppToken->loc, ~EEsProfile, "token pasting (##)");
-                parseContext.profileRequires(ppToken->loc, ~EEsProfile, 130, 0, "token pasting (##)");
-                subtoken = PpAtomPaste;
-            } else
-                ungetSubtoken();
-        }
-        break;
-    case PpAtomConstString:
-    case PpAtomIdentifier:
+    if (current >= stream.size())
+        return EndOfInput;
+
+    const Token& token = stream[current++];
+    int atom = token.atom;
+
+    // Check for ##, unless the current # is the last token
+    if (atom == '#' && current < stream.size() && stream[current].atom == '#') {
+        parseContext.requireProfile(ppToken->loc, ~EEsProfile, "token pasting (##)");
+        parseContext.profileRequires(ppToken->loc, ~EEsProfile, 130, 0, "token pasting (##)");
+        ++current;
+        return PpAtomPaste;
+    }
+
+    if (token.nameStart < 0)
+        return atom;
+
+    memcpy(ppToken->name, &names[token.nameStart], token.nameLength);
+    ppToken->name[token.nameLength] = 0;
+
+    switch (atom) {
     case PpAtomConstFloat:
     case PpAtomConstDouble:
 #ifdef AMD_EXTENSIONS
     case PpAtomConstFloat16:
 #endif
+        ppToken->dval = token.dval;
+        break;
     case PpAtomConstInt:
     case PpAtomConstUint:
-    case PpAtomConstInt64:
-    case PpAtomConstUint64:
 #ifdef AMD_EXTENSIONS
     case PpAtomConstInt16:
     case PpAtomConstUint16:
 #endif
-        len = 0;
-        ch = getSubtoken();
-        while (ch != 0 && ch != EndOfInput) {
-            if (len < MaxTokenLength) {
-                ppToken->name[len] = (char)ch;
-                len++;
-                ch = getSubtoken();
-            } else {
-                parseContext.error(ppToken->loc, "token too long", "", "");
-                break;
-            }
-        }
-        ppToken->name[len] = 0;
-
-        switch (subtoken) {
-        case PpAtomIdentifier:
-            break;
-        case PpAtomConstString:
-            break;
-        case PpAtomConstFloat:
-        case PpAtomConstDouble:
-#ifdef AMD_EXTENSIONS
-        case PpAtomConstFloat16:
-#endif
-            ppToken->dval = atof(ppToken->name);
-            break;
-        case PpAtomConstInt:
-#ifdef AMD_EXTENSIONS
-        case PpAtomConstInt16:
-#endif
-            if (len > 0 && ppToken->name[0] == '0') {
-                if (len > 1 && (ppToken->name[1] == 'x' || ppToken->name[1] == 'X'))
-                    ppToken->ival = (int)strtol(ppToken->name, 0, 16);
-                else
-                    ppToken->ival = (int)strtol(ppToken->name, 0, 8);
-            } else
-                ppToken->ival = atoi(ppToken->name);
-            break;
-        case PpAtomConstUint:
-#ifdef AMD_EXTENSIONS
-        case PpAtomConstUint16:
-#endif
-            if (len > 0 && ppToken->name[0] == '0') {
-                if (len > 1 && (ppToken->name[1] == 'x' || ppToken->name[1] == 'X'))
-                    ppToken->ival = (int)strtoul(ppToken->name, 0, 16);
-                else
-                    ppToken->ival = (int)strtoul(ppToken->name, 0, 8);
-            } else
-                ppToken->ival = (int)strtoul(ppToken->name, 0, 10);
-            break;
-        case PpAtomConstInt64:
-            if (len > 0 && ppToken->name[0] == '0') {
-                if (len > 1 && (ppToken->name[1] == 'x' || ppToken->name[1] == 'X'))
-                    ppToken->i64val = strtoll(ppToken->name, nullptr, 16);
-                else
-                    ppToken->i64val = strtoll(ppToken->name, nullptr, 8);
-            } else
-                ppToken->i64val = atoll(ppToken->name);
-            break;
-        case PpAtomConstUint64:
-            if (len > 0 && ppToken->name[0] == '0') {
-                if (len > 1 && (ppToken->name[1] == 'x' || ppToken->name[1] == 'X'))
-                    ppToken->i64val = (long long)strtoull(ppToken->name, nullptr, 16);
-                else
-                    ppToken->i64val = (long long)strtoull(ppToken->name, nullptr, 8);
-            } else
-                ppToken->i64val = (long long)strtoull(ppToken->name, 0, 10);
-            break;
-        }
+        ppToken->ival = token.ival;
+        break;
+    case PpAtomConstInt64:
+    case PpAtomConstUint64:
+        ppToken->i64val = token.i64val;
+        break;
+    default:
+        break;
     }
 
-    return subtoken;
+    return atom;
 }
 
 // We are pasting if
@@ -281,14 +260,11 @@ bool TPpContext::TokenStream::peekTokenizedPasting(bool lastTokenPastes)
 {
     // 1. preceding ##?
 
-    size_t savePos = current;
-    int subtoken;
+    size_t next = current;
     // skip white space
-    do {
-        subtoken = getSubtoken();
-    } while (subtoken == ' ');
-    current = savePos;
-    if (subtoken == PpAtomPaste)
+    while (next < stream.size() && stream[next].atom == ' ')
+        ++next;
+    if (next < stream.size() && stream[next].atom == PpAtomPaste)
         return true;
 
     // 2. last token and we've been told after this there will be a ##
@@ -298,45 +274,19 @@ bool TPpContext::TokenStream::peekTokenizedPasting(bool lastTokenPastes)
     // Getting here means the last token will be pasted, after this
 
     // Are we at the last non-whitespace token?
-    savePos = current;
-    bool moreTokens = false;
-    do {
-        subtoken = getSubtoken();
-        if (subtoken == EndOfInput)
-            break;
-        if (subtoken != ' ') {
-            moreTokens = true;
-            break;
-        }
-    } while (true);
-    current = savePos;
-
-    return !moreTokens;
+    return next == stream.size();
 }
 
 // See if the next non-white-space tokens are two consecutive #
 bool TPpContext::TokenStream::peekUntokenizedPasting()
 {
-    // don't return early, have to restore this
-    size_t savePos = current;
-
     // skip white-space
-    int subtoken;
-    do {
-        subtoken = getSubtoken();
-    } while (subtoken == ' ');
+    size_t next = current;
+    while (next < stream.size() && stream[next].atom == ' ')
+        ++next;
 
     // check for ##
-    bool pasting = false;
-    if (subtoken == '#') {
-        subtoken = getSubtoken();
-        if (subtoken == '#')
-            pasting = true;
-    }
-
-    current = savePos;
-
-    return pasting;
+    return next + 1 < stream.size() && stream[next].atom == '#' && stream[next + 1].atom == '#';
 }
 
 void TPpContext::pushTokenStreamInput(TokenStream& ts, bool prepasting)
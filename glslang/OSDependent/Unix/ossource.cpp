@@ -39,6 +39,7 @@
 #include "../../../OGLCompilersDLL/InitializeDll.h"
 
 #include <pthread.h>
+#include <sys/mman.h>
 #include <semaphore.h>
 #include <assert.h>
 #include <errno.h>
@@ -188,4 +189,26 @@ void OS_DumpMemoryCounters()
 {
 }
 
+void* OS_MapMemory(size_t size, bool hugePages)
+{
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return 0;
+
+#ifdef MADV_HUGEPAGE
+    // Only a hint; without transparent huge pages this fails and nothing changes.
+    if (hugePages)
+        madvise(memory, size, MADV_HUGEPAGE);
+#else
+    (void)hugePages;
+#endif
+
+    return memory;
+}
+
+void OS_UnmapMemory(void* memory, size_t size)
+{
+    munmap(memory, size);
+}
+
 } // end namespace glslang
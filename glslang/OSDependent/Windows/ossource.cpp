@@ -131,6 +131,17 @@ unsigned int __stdcall EnterGenericThread (void* entry)
     return ((TThreadEntrypoint)entry)(0);
 }
 
+// Large pages need a privilege most processes don't have, so 'hugePages' is not used.
+void* OS_MapMemory(size_t size, bool /*hugePages*/)
+{
+    return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+}
+
+void OS_UnmapMemory(void* memory, size_t /*size*/)
+{
+    VirtualFree(memory, 0, MEM_RELEASE);
+}
+
 //#define DUMP_COUNTERS
 
 void OS_DumpMemoryCounters()
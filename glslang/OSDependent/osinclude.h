@@ -35,6 +35,8 @@
 #ifndef __OSINCLUDE_H
 #define __OSINCLUDE_H
 
+#include <cstddef>
+
 namespace glslang {
 
 //
@@ -58,6 +60,14 @@ void OS_CleanupThreadData(void);
 
 void OS_DumpMemoryCounters();
 
+//
+// Memory mapped directly from the OS, for big blocks.  With 'hugePages', ask
+// for it to be backed by huge pages where the OS supports that.  Returns 0
+// if it couldn't be mapped.
+//
+void* OS_MapMemory(size_t size, bool hugePages);
+void  OS_UnmapMemory(void* memory, size_t size);
+
 } // end namespace glslang
 
 #endif // __OSINCLUDE_H
@@ -317,13 +317,166 @@ int GetKhronosToolId();
 class TIntermediate;
 class TProgram;
 class TPoolAllocator;
+class TPpContext;
 
 // Call this exactly once per process before using anything else
 bool InitializeProcess();
 
+// Same, but first try loading built-in symbol tables from a file written by
+// SaveBuiltInSymbolTables(); if that fails they are parsed as needed, as usual.
+bool InitializeProcess(const char* builtInCacheFileName);
+
 // Call once per process to tear down everything
 void FinalizeProcess();
 
+// Write all the built-in symbol tables made so far by this process to a file,
+// so later processes can load them instead of parsing the built-ins again.
+// The file is only usable by the same build of glslang.  Returns false on failure.
+bool SaveBuiltInSymbolTables(const char* fileName);
+
+// Load built-in symbol tables from a file written by SaveBuiltInSymbolTables(),
+// after InitializeProcess().  Returns false if the file is missing, corrupt,
+// or was written by a different build; nothing is lost in that case.
+bool LoadBuiltInSymbolTables(const char* fileName);
+
+// Describes a kind of compile whose built-in symbol tables are wanted ahead of time,
+// in the same terms the compile itself will use: its stage, its #version and profile
+// (a profile of ENoProfile gets the same default as a shader with none), the messages
+// that will be passed to TShader::parse(), and the environment, if any, that will be
+// set on the TShader.
+struct TBuiltInWarmUp {
+    EShLanguage stage;
+    int version;
+    EProfile profile;
+    EShMessages messages;
+    const TEnvironment* environment;  // nullptr if not using setEnv*()
+};
+
+// Build the built-in symbol tables for 'count' kinds of compiles, spread across up to
+// 'numThreads' threads, so first compiles don't pay for it.  Call after InitializeProcess().
+// Returns false if any of them do not describe a correct version and profile; the
+// tables a compile would fall back to are still built.
+bool WarmUpBuiltInSymbolTables(const TBuiltInWarmUp* warmUps, int count, int numThreads);
+
+// Memory used by the pool allocator(s) behind a TShader or TProgram, for sizing
+// workers and spotting pathological shaders.  Byte counts are of pool pages, which
+// is what the pools actually take from the system.
+struct TPoolStats {
+    TPoolStats() { memset(this, 0, sizeof(TPoolStats)); }
+
+    // Add in another pool's statistics.  Peaks add up, as if the pools peaked
+    // at the same time; the largest allocation and push depths are maximums.
+    TPoolStats& operator+=(const TPoolStats& other)
+    {
+        numAllocations += other.numAllocations;
+        bytesRequested += other.bytesRequested;
+        bytesInUse += other.bytesInUse;
+        peakBytesInUse += other.peakBytesInUse;
+        bytesReserved += other.bytesReserved;
+        pagesInUse += other.pagesInUse;
+        freePages += other.freePages;
+        multiPageAllocations += other.multiPageAllocations;
+        if (other.largestMultiPageAllocation > largestMultiPageAllocation)
+            largestMultiPageAllocation = other.largestMultiPageAllocation;
+        if (other.pushDepth > pushDepth)
+            pushDepth = other.pushDepth;
+        if (other.maxPushDepth > maxPushDepth)
+            maxPushDepth = other.maxPushDepth;
+        return *this;
+    }
+
+    int numAllocations;                // calls to allocate()
+    size_t bytesRequested;             // sum of the sizes asked for
+    size_t bytesInUse;                 // in pages holding allocations, now
+    size_t peakBytesInUse;             // high-water mark of bytesInUse
+    size_t bytesReserved;              // bytesInUse, plus pages kept on the free list
+    int pagesInUse;                    // a multi-page allocation counts as one
+    int freePages;                     // length of the free list
+    int multiPageAllocations;          // allocations too big for one page, so far
+    size_t largestMultiPageAllocation; // in bytes asked for
+    int pushDepth;                     // push()es outstanding, now
+    int maxPushDepth;                  // ...and at most
+};
+
+// How pool allocators get their memory.  The defaults are what a TPoolConfig is
+// constructed with.
+struct TPoolConfig {
+    TPoolConfig() : pageSize(8 * 1024), maxPageSize(256 * 1024), hugePages(false),
+                    largePageCacheSize(16 * 1024 * 1024), threadPageCacheSize(1024 * 1024) { }
+
+    int pageSize;            // bytes in a pool's first page
+    int maxPageSize;         // each new page doubles in size, up to this
+    bool hugePages;          // map blocks of 2MB or more from the OS, asking for huge pages (Linux)
+    int largePageCacheSize;  // bytes of multi-page allocations kept, process wide, for later compiles
+    int threadPageCacheSize; // bytes of pages kept by each thread, from the pools of finished
+                             // TShaders and TPrograms, for its next ones
+};
+
+// Change how pool allocators get their memory.  Call when nothing is being compiled
+// or linked; pools already made keep their page sizes.
+void SetPoolConfig(const TPoolConfig&);
+
+// An application's own allocator, for the pages of the pool allocators, which hold
+// nearly all the memory of compiling and linking.  allocatePage() returns memory
+// aligned as for new, or nullptr if there is none.  freePage() gets back the size
+// that was asked for.  Both are passed userData, and may be called by several threads
+// at once, as many as are compiling or linking.  Pages are kept for reuse within
+// the limits set by TPoolConfig; set those to 0 to have each page freed as soon as
+// its pool is done with it.
+struct TAllocatorCallbacks {
+    void* (*allocatePage)(void* userData, size_t size);
+    void (*freePage)(void* userData, void* memory, size_t size);
+    void* userData;
+};
+
+// Get pool pages from 'callbacks' from now on, or from the default allocator if
+// nullptr.  Call when nothing is being compiled or linked.  Pages are always
+// freed by the allocator they came from: the previous allocator still gets back
+// the pages of TShaders and TPrograms not yet deleted, and those cached by other
+// threads, which free them on their next compile or link, or when they exit.
+// A threadPageCacheSize of 0 in TPoolConfig keeps threads from caching any.
+void SetAllocatorCallbacks(const TAllocatorCallbacks* callbacks);
+
+// Keep up to 'maxBytes' of the scanned tokens of #included headers, process wide,
+// for compiles that include the same header again (same resolved name and text),
+// of any TShader on any thread.  What the header's directives and macros do is
+// still worked out by each compile.  0, the default, turns the cache off and
+// empties it.  Can be called at any time; ShFinalize() also empties it.
+void SetIncludeCacheSize(size_t maxBytes);
+
+// The tokens scanned from a shader's strings, shared by TShaders that have the same
+// strings but different preambles, such as the permutations of a set of #defines
+// given to setPreamble().  The first of those to be parsed or preprocessed records
+// the tokens, and the others replay them rather than scanning the strings again.
+//
+// This is only a replay cache for the lexing, and a partial answer to compiling
+// permutations once.  Each shader still preprocesses all of its strings itself,
+// with its own #defines, #ifs, and macro expansion, and parses the result.  It
+// saves at most the time spent scanning, which is typically a small part of a
+// compile.
+//
+// Not done yet: preprocessing the tokens up to the first #if that depends on the
+// preamble once for all the shaders, and forking there.  That needs the macro
+// table and #if state saved at the fork.  See the TODO in PpScanner.cpp.
+//
+// Can be shared by shaders on different threads; while one records, the others
+// scan for themselves.  Must outlive their parsing.  If the strings change, the
+// next shader to be parsed records them again.
+class TScannedSource {
+public:
+    TScannedSource();
+    ~TScannedSource();
+
+protected:
+    TScannedSource(const TScannedSource&);
+    TScannedSource& operator=(const TScannedSource&);
+
+    friend class TPpContext;
+
+    struct TData;
+    TData* data;
+};
+
 // Make one TShader per shader that you will link into a program.  Then provide
 // the shader through setStrings() or setStringsWithLengths(), then call parse(),
 // then query the info logs.
@@ -361,6 +514,16 @@ public:
     void setNoStorageFormat(bool useUnknownFormat);
     void setTextureSamplerTransformMode(EShTextureSamplerTransformMode mode);
 
+    // Limit the memory parse() and preprocess() may use, in bytes of pool pages (see
+    // TPoolStats), counting the built-in symbols the shader starts with; 0, the
+    // default, for no limit.  Going over stops the compile with a "memory limit
+    // exceeded" error.
+    void setMemoryLimit(size_t bytes) { memoryLimit = bytes; }
+
+    // Replay the scanning of this shader's strings from 'scanned', shared with other
+    // shaders having the same strings, or record it there; see TScannedSource.
+    void setScannedSource(TScannedSource* scanned) { scannedSource = scanned; }
+
     // For setting up the environment (initialized in the constructor):
     void setEnvInput(EShSource lang, EShLanguage stage, EShClient client, int version)
     {
@@ -493,6 +656,9 @@ public:
     const char* getInfoLog();
     const char* getInfoDebugLog();
 
+    // Memory used by this shader's pool; all zero before parse() or preprocess().
+    void getPoolStats(TPoolStats&) const;
+
     EShLanguage getStage() const { return stage; }
 
 protected:
@@ -521,6 +687,9 @@ protected:
 
     TEnvironment environment;
 
+    size_t memoryLimit;
+    TScannedSource* scannedSource;
+
     friend class TProgram;
 
 private:
@@ -600,9 +769,17 @@ public:
 
     // Link Validation interface
     bool link(EShMessages);
+
+    // As above, but linking up to numThreads stages at a time, each in its own pool.
+    // The info log is the same as when linking the stages one at a time.
+    bool link(EShMessages, int numThreads);
     const char* getInfoLog();
     const char* getInfoDebugLog();
 
+    // Memory used by linking, totaled over the program's pools; the shaders'
+    // own pools are reported by TShader::getPoolStats().
+    void getPoolStats(TPoolStats&) const;
+
     TIntermediate* getIntermediate(EShLanguage stage) const { return intermediate[stage]; }
 
     // Reflection Interface
@@ -634,9 +811,10 @@ public:
     bool mapIO(TIoMapResolver* resolver = NULL);
 
 protected:
-    bool linkStage(EShLanguage, EShMessages);
+    bool linkStage(EShLanguage, EShMessages, TInfoSink&);
 
     TPoolAllocator* pool;
+    TPoolAllocator* stagePools[EShLangCount];  // when stages are linked concurrently
     std::list<TShader*> stages[EShLangCount];
     TIntermediate* intermediate[EShLangCount];
     bool newedIntermediate[EShLangCount];      // track which intermediate were "new" versus reusing a singleton unit in a stage
@@ -650,6 +828,75 @@ private:
     TProgram& operator=(TProgram&);
 };
 
+// Compile, and optionally link, many jobs on a pool of threads.  Add all the
+// jobs, then call run().  Each thread handles whole jobs, taking the next one
+// not yet taken until there are none, and results are kept in the order the
+// jobs were added.
+//
+// To do more with each linked program on the thread that linked it (e.g.,
+// generate SPIR-V), derive from this and override linked().
+//
+// N.B.: Destruct the batch *before* destructing the shaders in its jobs.
+//
+class TCompileBatch {
+public:
+    // The shaders are to be set up (setStrings(), setEntryPoint(), etc.) but
+    // not yet parsed.  They are all parsed as given here, then, if link is
+    // set, linked together into one program.  An includer is used by just one
+    // thread at a time only if it belongs to just one job.
+    struct TJob {
+        TJob() : resources(nullptr), defaultVersion(100), defaultProfile(ENoProfile),
+                 forceDefaultVersionAndProfile(false), forwardCompatible(false),
+                 messages(EShMsgDefault), includer(nullptr), link(true) { }
+
+        std::vector<TShader*> shaders;
+        const TBuiltInResource* resources;
+        int defaultVersion;
+        EProfile defaultProfile;
+        bool forceDefaultVersionAndProfile;
+        bool forwardCompatible;
+        EShMessages messages;
+        TShader::Includer* includer;  // nullptr to forbid #include
+        bool link;
+    };
+
+    explicit TCompileBatch(int numThreads);
+    virtual ~TCompileBatch();
+
+    // Returns the index of the job, for getting its results.
+    int add(const TJob&);
+
+    // Run all the jobs added since the last run(), on up to numThreads threads,
+    // including the calling one.  Returns true if all of them succeeded.
+    bool run();
+
+    int getNumJobs() const { return (int)jobs.size(); }
+    bool getSuccess(int job) const { return results[job].success; }
+    TProgram* getProgram(int job) const { return results[job].program; }  // nullptr if not linked
+
+protected:
+    // Called on the thread running the job, after all its shaders parsed
+    // and linked successfully.
+    virtual void linked(int /*job*/, TProgram&) { }
+
+    bool runJob(int job);
+
+    struct TResult {
+        TResult() : success(false), program(nullptr) { }
+        bool success;
+        TProgram* program;
+    };
+
+    int numThreads;
+    int numRun;  // jobs already run
+    std::vector<TJob> jobs;
+    std::vector<TResult> results;
+
+private:
+    TCompileBatch(TCompileBatch&);
+    TCompileBatch& operator=(TCompileBatch&);
+};
+
 } // end namespace glslang
 
 #endif // _COMPILER_INTERFACE_INCLUDED_
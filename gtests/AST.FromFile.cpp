@@ -35,6 +35,7 @@
 #include <gtest/gtest.h>
 
 #include "TestFixture.h"
+#include "glslang/Include/PoolAlloc.h"
 
 namespace glslangtest {
 namespace {
@@ -48,6 +49,45 @@ TEST_P(CompileToAstTest, FromFile)
                             Target::AST);
 }
 
+using MemoryLimitTest = GlslangTest<::testing::Test>;
+
+// A compile needing more memory than its limit stops with an error.
+TEST_F(MemoryLimitTest, ExceededIsAnError)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+    std::string contents = "#version 450\n";
+    for (int i = 0; i < 20000; ++i)
+        contents += "float f" + std::to_string(i) + " = " + std::to_string(i) + ".0;\n";
+
+    glslang::TShader unlimited(EShLangVertex);
+    EXPECT_TRUE(compile(&unlimited, contents, "", controls));
+
+    glslang::TShader limited(EShLangVertex);
+    limited.setMemoryLimit(1024 * 1024);
+    EXPECT_FALSE(compile(&limited, contents, "", controls));
+    EXPECT_NE(std::string(limited.getInfoLog()).find("ERROR: memory limit exceeded"), std::string::npos);
+}
+
+// A page cached from an earlier pool is only reused if it fits in the limit.
+TEST_F(MemoryLimitTest, CachedPagesStayWithinTheLimit)
+{
+    // Have this thread's page cache hold just one big page.
+    glslang::SetAllocatorCallbacks(nullptr);
+    {
+        glslang::TPoolAllocator bigPages(64 * 1024);
+        bigPages.allocate(16);
+    }
+
+    const size_t limit = 32 * 1024;
+    glslang::TPoolAllocator limited;
+    limited.setLimit(limit);
+    limited.allocate(16);
+
+    glslang::TPoolStats stats;
+    limited.getStats(stats);
+    EXPECT_LE(stats.bytesInUse, limit);
+}
+
 // clang-format off
 INSTANTIATE_TEST_CASE_P(
     Glsl, CompileToAstTest,
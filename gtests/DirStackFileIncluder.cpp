@@ -0,0 +1,227 @@
+//
+// Copyright (C) 2017 Google, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of Google Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef _WIN32
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "StandAlone/DirStackFileIncluder.h"
+
+namespace glslangtest {
+namespace {
+
+// Makes a directory for the files of a test, removing them after it.
+class IncludeFileCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        char name[] = "/tmp/glslangtestsXXXXXX";
+        ASSERT_NE(mkdtemp(name), nullptr);
+        root = name;
+    }
+
+    void TearDown() override
+    {
+        for (const auto& path : written)
+            remove(path.c_str());
+        for (auto dir = dirs.rbegin(); dir != dirs.rend(); ++dir)
+            rmdir(dir->c_str());
+        rmdir(root.c_str());
+    }
+
+    std::string makeDir(const std::string& name)
+    {
+        const std::string dir = root + "/" + name;
+        EXPECT_EQ(mkdir(dir.c_str(), 0700), 0);
+        dirs.push_back(dir);
+        return dir;
+    }
+
+    // Writes 'contents' to a new file, replacing any at 'path'.
+    std::string write(const std::string& path, const std::string& contents)
+    {
+        const std::string temp = path + ".new";
+        std::ofstream(temp, std::ios_base::binary) << contents;
+        EXPECT_EQ(rename(temp.c_str(), path.c_str()), 0);
+        written.push_back(path);
+        return path;
+    }
+
+    static std::string text(const IncludeFileCache::File& file)
+    {
+        return std::string(file.getData(), file.getLength());
+    }
+
+    static std::string text(const glslang::TShader::Includer::IncludeResult& result)
+    {
+        return std::string(result.headerData, result.headerLength);
+    }
+
+    std::string root;
+    std::vector<std::string> dirs;
+    std::vector<std::string> written;
+};
+
+TEST_F(IncludeFileCacheTest, KeepsFilesUntilTheyChange)
+{
+    IncludeFileCache cache;
+    const std::string path = write(root + "/a.h", "float a;\n");
+
+    const auto first = cache.getFile(path);
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(text(*first), "float a;\n");
+    EXPECT_EQ(cache.getFile(path), first);
+
+    // A new file of the same size is still noticed, by its inode.
+    write(path, "float b;\n");
+    const auto second = cache.getFile(path);
+    ASSERT_NE(second, nullptr);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(text(*second), "float b;\n");
+    EXPECT_EQ(text(*first), "float a;\n");
+
+    write(path, "float longer;\n");
+    EXPECT_EQ(text(*cache.getFile(path)), "float longer;\n");
+}
+
+TEST_F(IncludeFileCacheTest, ReadsSmallEmptyAndLargeFiles)
+{
+    IncludeFileCache cache;
+
+    const auto empty = cache.getFile(write(root + "/empty.h", ""));
+    ASSERT_NE(empty, nullptr);
+    EXPECT_EQ(empty->getLength(), 0u);
+
+    const std::string large(IncludeFileCache::MinMappedLength + 3, 'x');
+    const auto mapped = cache.getFile(write(root + "/large.h", large));
+    ASSERT_NE(mapped, nullptr);
+    EXPECT_EQ(text(*mapped), large);
+
+    EXPECT_EQ(cache.getFile(root + "/missing.h"), nullptr);
+    EXPECT_EQ(cache.getFile(root), nullptr);
+}
+
+TEST_F(IncludeFileCacheTest, DropsLeastRecentlyUsedFiles)
+{
+    IncludeFileCache cache(2, 20);
+    const std::string a = write(root + "/a.h", "float a;\n");
+    const std::string b = write(root + "/b.h", "float b;\n");
+    const std::string c = write(root + "/c.h", "float c;\n");
+
+    const auto first = cache.getFile(a);
+    cache.getFile(b);
+    EXPECT_EQ(cache.getFileCount(), 2u);
+    EXPECT_EQ(cache.getByteCount(), 18u);
+
+    // Using a.h makes b.h the one dropped for c.h.
+    EXPECT_EQ(cache.getFile(a), first);
+    cache.getFile(c);
+    EXPECT_EQ(cache.getFileCount(), 2u);
+    EXPECT_EQ(cache.getFile(a), first);
+
+    // Over the byte limit, older files go, but the newest is kept.
+    const std::string large = write(root + "/large.h", std::string(30, 'x'));
+    EXPECT_EQ(cache.getFile(large)->getLength(), 30u);
+    EXPECT_EQ(cache.getFileCount(), 1u);
+    EXPECT_EQ(cache.getByteCount(), 30u);
+    EXPECT_EQ(text(*first), "float a;\n");
+
+    // A file that's gone is dropped too.
+    remove(large.c_str());
+    EXPECT_EQ(cache.getFile(large), nullptr);
+    EXPECT_EQ(cache.getFileCount(), 0u);
+    EXPECT_EQ(cache.getByteCount(), 0u);
+}
+
+TEST_F(IncludeFileCacheTest, IncluderFindsHeadersAddedEarlierInTheSearch)
+{
+    IncludeFileCache cache;
+    const std::string first = makeDir("first");
+    const std::string second = makeDir("second");
+    const std::string includer = write(root + "/main.vert", "#include \"h.h\"\n");
+    write(first + "/h.h", "float first;\n");
+
+    CachingDirStackFileIncluder includerA(cache);
+    includerA.pushExternalLocalDirectory(first);
+    includerA.pushExternalLocalDirectory(second);
+    auto* result = includerA.includeLocal("h.h", includer.c_str(), 1);
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(text(*result), "float first;\n");
+
+    // What's released by one includer stays valid for others, even after clear().
+    CachingDirStackFileIncluder includerB(cache);
+    includerB.pushExternalLocalDirectory(first);
+    includerB.pushExternalLocalDirectory(second);
+    auto* shared = includerB.includeLocal("h.h", includer.c_str(), 1);
+    ASSERT_NE(shared, nullptr);
+    EXPECT_EQ(shared->headerName, first + "/h.h");
+    includerA.releaseInclude(result);
+    cache.clear();
+    EXPECT_EQ(text(*shared), "float first;\n");
+    includerB.releaseInclude(shared);
+
+    // The most recently pushed directory is searched first, so a header
+    // created there later hides the one found before.
+    result = includerA.includeLocal("h.h", includer.c_str(), 1);
+    ASSERT_NE(result, nullptr);
+    includerA.releaseInclude(result);
+    write(second + "/h.h", "float second;\n");
+    result = includerA.includeLocal("h.h", includer.c_str(), 1);
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(result->headerName, second + "/h.h");
+    EXPECT_EQ(text(*result), "float second;\n");
+    includerA.releaseInclude(result);
+
+    remove((second + "/h.h").c_str());
+    result = includerA.includeLocal("h.h", includer.c_str(), 1);
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(result->headerName, first + "/h.h");
+    EXPECT_EQ(text(*result), "float first;\n");
+    includerA.releaseInclude(result);
+
+    remove((first + "/h.h").c_str());
+    EXPECT_EQ(includerA.includeLocal("h.h", includer.c_str(), 1), nullptr);
+}
+
+}  // anonymous namespace
+}  // namespace glslangtest
+
+#endif
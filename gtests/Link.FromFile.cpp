@@ -32,11 +32,15 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <atomic>
+#include <future>
 #include <memory>
+#include <thread>
 
 #include <gtest/gtest.h>
 
 #include "TestFixture.h"
+#include "glslang/Include/PoolAlloc.h"
 
 namespace glslangtest {
 namespace {
@@ -44,45 +48,262 @@ namespace {
 using LinkTest = GlslangTest<
     ::testing::TestWithParam<std::vector<std::string>>>;
 
-TEST_P(LinkTest, FromFile)
+// Checks that a pool's statistics are consistent with each other.
+void checkPoolStats(const glslang::TPoolStats& stats)
+{
+    EXPECT_LE(stats.bytesInUse, stats.peakBytesInUse);
+    EXPECT_LE(stats.pushDepth, stats.maxPushDepth);
+    EXPECT_LE(stats.largestMultiPageAllocation, stats.bytesRequested);
+}
+
+// A pool counts exactly what was asked of it, including what pop() released.
+TEST(PoolStats, CountsAllocationsPushesAndMultiPageAllocations)
+{
+    glslang::TPoolAllocator pool;
+    glslang::TPoolStats stats;
+    pool.getStats(stats);
+    const int baseDepth = stats.pushDepth;
+    EXPECT_EQ(stats.numAllocations, 0);
+    EXPECT_EQ(stats.bytesRequested, 0u);
+    EXPECT_EQ(stats.pagesInUse, 0);
+    EXPECT_EQ(stats.maxPushDepth, baseDepth);
+
+    pool.allocate(100);
+    pool.allocate(200);
+    pool.getStats(stats);
+    EXPECT_EQ(stats.numAllocations, 2);
+    EXPECT_EQ(stats.bytesRequested, 300u);
+    EXPECT_EQ(stats.pagesInUse, 1);
+    EXPECT_EQ(stats.multiPageAllocations, 0);
+    const size_t basePageBytes = stats.bytesInUse;
+
+    // A push() starts a new page; a multi-page allocation is a page of its own.
+    pool.push();
+    pool.allocate(50);
+    pool.push();
+    pool.allocate(1024 * 1024);
+    pool.getStats(stats);
+    EXPECT_EQ(stats.pushDepth, baseDepth + 2);
+    EXPECT_EQ(stats.pagesInUse, 3);
+    EXPECT_EQ(stats.multiPageAllocations, 1);
+    EXPECT_EQ(stats.largestMultiPageAllocation, 1024u * 1024u);
+    EXPECT_GT(stats.bytesInUse, basePageBytes + 1024 * 1024);
+    const size_t peak = stats.bytesInUse;
+
+    pool.pop();
+    pool.allocate(512 * 1024);
+    pool.pop();
+    pool.getStats(stats);
+    EXPECT_EQ(stats.numAllocations, 5);
+    EXPECT_EQ(stats.bytesRequested, 300u + 50u + 1024u * 1024u + 512u * 1024u);
+    EXPECT_EQ(stats.pushDepth, baseDepth);
+    EXPECT_EQ(stats.maxPushDepth, baseDepth + 2);
+    EXPECT_EQ(stats.multiPageAllocations, 2);
+    EXPECT_EQ(stats.largestMultiPageAllocation, 1024u * 1024u);
+    EXPECT_EQ(stats.pagesInUse, 1);
+    EXPECT_EQ(stats.bytesInUse, basePageBytes);
+    EXPECT_EQ(stats.peakBytesInUse, peak);
+    EXPECT_EQ(stats.freePages, 1);
+    EXPECT_GT(stats.bytesReserved, stats.bytesInUse);
+
+    // What was asked for over the pool's life passes its peak.
+    EXPECT_GT(stats.bytesRequested, stats.peakBytesInUse - basePageBytes);
+}
+
+// Checks the results of compiling and linking the given files against the
+// expected ones.
+void checkLinkResults(LinkTest& test, const std::vector<std::string>& fileNames,
+                      const std::vector<std::unique_ptr<glslang::TShader>>& shaders,
+                      glslang::TProgram& program, EShMessages controls)
+{
+    LinkTest::GlslangResult result;
+    for (size_t i = 0; i < fileNames.size(); ++i) {
+        result.shaderResults.push_back(
+            {fileNames[i], shaders[i]->getInfoLog(), shaders[i]->getInfoDebugLog()});
+    }
+    result.linkingOutput = program.getInfoLog();
+    result.linkingError = program.getInfoDebugLog();
+
+    glslang::TPoolStats stats;
+    for (const auto& shader : shaders) {
+        shader->getPoolStats(stats);
+        EXPECT_GT(stats.numAllocations, 0);
+        checkPoolStats(stats);
+    }
+    program.getPoolStats(stats);
+    checkPoolStats(stats);
+
+    std::ostringstream stream;
+    test.outputResultToStream(&stream, result, controls);
+
+    // Check with expected results.
+    const std::string expectedOutputFname =
+        GlobalTestSettings.testRoot + "/baseResults/" + fileNames.front() + ".out";
+    std::string expectedOutput;
+    test.tryLoadFile(expectedOutputFname, "expected output", &expectedOutput);
+
+    test.checkEqAndUpdateIfRequested(expectedOutput, stream.str(), expectedOutputFname);
+}
+
+// Compiles and links the given files, linking up to numThreads stages at a
+// time, and checks the results against the expected ones.
+void linkFromFiles(LinkTest& test, const std::vector<std::string>& fileNames, int numThreads)
 {
-    const auto& fileNames = GetParam();
     const size_t fileCount = fileNames.size();
     const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
-    GlslangResult result;
 
     // Compile each input shader file.
     std::vector<std::unique_ptr<glslang::TShader>> shaders;
     for (size_t i = 0; i < fileCount; ++i) {
         std::string contents;
-        tryLoadFile(GlobalTestSettings.testRoot + "/" + fileNames[i],
+        test.tryLoadFile(GlobalTestSettings.testRoot + "/" + fileNames[i],
                     "input", &contents);
         shaders.emplace_back(
                 new glslang::TShader(GetShaderStage(GetSuffix(fileNames[i]))));
         auto* shader = shaders.back().get();
-        compile(shader, contents, "", controls);
-        result.shaderResults.push_back(
-            {fileNames[i], shader->getInfoLog(), shader->getInfoDebugLog()});
+        test.compile(shader, contents, "", controls);
     }
 
     // Link all of them.
     glslang::TProgram program;
     for (const auto& shader : shaders) program.addShader(shader.get());
-    program.link(controls);
-    result.linkingOutput = program.getInfoLog();
-    result.linkingError = program.getInfoDebugLog();
+    program.link(controls, numThreads);
 
-    std::ostringstream stream;
-    outputResultToStream(&stream, result, controls);
+    checkLinkResults(test, fileNames, shaders, program, controls);
+}
 
-    // Check with expected results.
-    const std::string expectedOutputFname =
-        GlobalTestSettings.testRoot + "/baseResults/" + fileNames.front() + ".out";
-    std::string expectedOutput;
-    tryLoadFile(expectedOutputFname, "expected output", &expectedOutput);
+// Compiles and links the given files, as several jobs of the same batch, and
+// checks the results of each against the expected ones.
+void batchLinkFromFiles(LinkTest& test, const std::vector<std::string>& fileNames)
+{
+    const int numJobs = 3;
+    const size_t fileCount = fileNames.size();
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+
+    std::vector<std::string> contents(fileCount);
+    std::vector<const char*> strings(fileCount);
+    std::vector<int> lengths(fileCount);
+    for (size_t i = 0; i < fileCount; ++i) {
+        test.tryLoadFile(GlobalTestSettings.testRoot + "/" + fileNames[i],
+                    "input", &contents[i]);
+        strings[i] = contents[i].data();
+        lengths[i] = static_cast<int>(contents[i].size());
+    }
+
+    std::vector<std::unique_ptr<glslang::TShader>> shaders[numJobs];
+    glslang::TCompileBatch batch(numJobs);
+    for (int j = 0; j < numJobs; ++j) {
+        glslang::TCompileBatch::TJob job;
+        for (size_t i = 0; i < fileCount; ++i) {
+            shaders[j].emplace_back(
+                    new glslang::TShader(GetShaderStage(GetSuffix(fileNames[i]))));
+            shaders[j].back()->setStringsWithLengths(&strings[i], &lengths[i], 1);
+            job.shaders.push_back(shaders[j].back().get());
+        }
+        job.resources = &glslang::DefaultTBuiltInResource;
+        job.messages = controls;
+        EXPECT_EQ(j, batch.add(job));
+    }
+    batch.run();
+
+    for (int j = 0; j < numJobs; ++j)
+        checkLinkResults(test, fileNames, shaders[j], *batch.getProgram(j), controls);
+}
+
+// An application allocator that counts the pool pages it hands out and gets back.
+// Pages can outlive a test, so it does too.
+struct CountingAllocator {
+    std::atomic<size_t> allocated;
+    std::atomic<size_t> freed;
+};
+CountingAllocator countingAllocator;
+
+void* countingAllocatePage(void* userData, size_t size)
+{
+    static_cast<CountingAllocator*>(userData)->allocated += size;
+    return ::operator new(size);
+}
+
+void countingFreePage(void* userData, void* memory, size_t size)
+{
+    static_cast<CountingAllocator*>(userData)->freed += size;
+    ::operator delete(memory);
+}
+
+TEST_P(LinkTest, FromFile)
+{
+    linkFromFiles(*this, GetParam(), 1);
+}
+
+TEST_P(LinkTest, FromFileConcurrently)
+{
+    linkFromFiles(*this, GetParam(), 4);
+}
+
+TEST_P(LinkTest, FromFileBatch)
+{
+    batchLinkFromFiles(*this, GetParam());
+}
+
+TEST_P(LinkTest, FromFileWithAllocatorCallbacks)
+{
+    const size_t allocated = countingAllocator.allocated;
+    const size_t freed = countingAllocator.freed;
+    const glslang::TAllocatorCallbacks callbacks = { countingAllocatePage, countingFreePage, &countingAllocator };
+    glslang::SetAllocatorCallbacks(&callbacks);
+    linkFromFiles(*this, GetParam(), 4);
+    glslang::SetAllocatorCallbacks(nullptr);
+
+    // Built-in symbol tables made along the way are kept until the process finalizes,
+    // but the shaders' and program's pages are given back.
+    EXPECT_GT(countingAllocator.allocated.load(), allocated);
+    EXPECT_GT(countingAllocator.freed.load(), freed);
+    EXPECT_LE(countingAllocator.freed.load(), countingAllocator.allocated.load());
+}
+
+#ifndef GLSLANG_OS_TLS_POOL_ALLOCATOR
+// Pages another thread cached from the previous allocator are given back to it,
+// not handed out to pools made after the allocator changed.
+TEST(AllocatorCallbacks, OtherThreadsDropStalePages)
+{
+    static CountingAllocator previousAllocator;
+    const std::string code = "#version 450\nvoid main() { vec4 v = vec4(1.0); }\n";
+    const auto compile = [&code]() {
+        glslang::TShader shader(EShLangFragment);
+        const char* strings = code.c_str();
+        shader.setStrings(&strings, 1);
+        EXPECT_TRUE(shader.parse(&glslang::DefaultTBuiltInResource, 100, false, EShMsgDefault));
+    };
+
+    // Have the built-in symbol tables made with the default allocator.
+    compile();
+
+    const glslang::TAllocatorCallbacks callbacks = { countingAllocatePage, countingFreePage, &previousAllocator };
+    glslang::SetAllocatorCallbacks(&callbacks);
+
+    std::promise<void> cached;
+    std::promise<void> switched;
+    std::future<void> switchedFuture = switched.get_future();
+    size_t freedBefore = 0;
+    size_t freedAfter = 0;
+    std::thread thread([&]() {
+        compile();
+        freedBefore = previousAllocator.freed;
+        cached.set_value();
+        switchedFuture.wait();
+        compile();
+        freedAfter = previousAllocator.freed;
+    });
+
+    cached.get_future().wait();
+    glslang::SetAllocatorCallbacks(nullptr);
+    switched.set_value();
+    thread.join();
 
-    checkEqAndUpdateIfRequested(expectedOutput, stream.str(), expectedOutputFname);
+    EXPECT_GT(previousAllocator.allocated.load(), 0u);
+    EXPECT_GT(freedAfter, freedBefore);
 }
+#endif
 
 // clang-format off
 INSTANTIATE_TEST_CASE_P(
@@ -32,6 +32,8 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <thread>
+
 #include <gtest/gtest.h>
 
 #include "TestFixture.h"
@@ -46,6 +48,162 @@ TEST_P(PreprocessingTest, FromFile)
     loadFilePreprocessAndCheck(GlobalTestSettings.testRoot, GetParam());
 }
 
+using ScannedSourceTest = GlslangTest<::testing::Test>;
+
+// A shader in two strings, with code differing by #define.
+const char* const permutedStrings[] = {
+    "#version 450\n"
+    "#ifdef A\n"
+    "uniform float a;\n"
+    "float f(float x) { return x * a + 1.5e-3; }\n"
+    "#else\n"
+    "float f(float x) { return x - 0x1F; } // not A\n"
+    "#endif\n",
+    "#if defined(B) && B > 1\n"
+    "#define SCALE(v) ((v) * float(B))\n"
+    "#else\n"
+    "#define SCALE(v) (v)\n"
+    "#endif\n"
+    "out vec4 color;\n"
+    "void main() { color = vec4(SCALE(f(2.0)), 1u, .5, 1.0); }\n",
+};
+const char* const otherStrings[] = {
+    "#version 450\n",
+    "out vec4 color;\n"
+    "void main() { color = vec4(B); }\n",
+};
+const char* const permutations[] = { "", "#define A\n", "#define B 2\n", "#define A\n#define B 3\n" };
+
+// The info logs and AST of compiling, and linking, the strings with the preamble,
+// or what preprocessing them puts out, sharing 'scanned' if it isn't nullptr.
+std::string compileWithPreamble(const char* const* strings, int count, const char* preamble,
+                                glslang::TScannedSource* scanned, size_t memoryLimit = 0)
+{
+    const EShMessages controls = DeriveOptions(Source::GLSL, Semantics::OpenGL, Target::AST);
+    glslang::TShader shader(EShLangFragment);
+    shader.setStrings(strings, count);
+    shader.setPreamble(preamble);
+    shader.setScannedSource(scanned);
+    shader.setMemoryLimit(memoryLimit);
+    std::string output;
+    glslang::TProgram program;
+    if (shader.parse(&glslang::DefaultTBuiltInResource, 100, false, controls)) {
+        program.addShader(&shader);
+        program.link(controls);
+        output = std::string(program.getInfoLog()) + program.getInfoDebugLog();
+    }
+
+    return std::string(shader.getInfoLog()) + shader.getInfoDebugLog() + output;
+}
+
+std::string parseWithPreamble(const char* const* strings, const char* preamble, glslang::TScannedSource* scanned)
+{
+    return compileWithPreamble(strings, 2, preamble, scanned);
+}
+
+std::string preprocessWithPreamble(const char* const* strings, const char* preamble, glslang::TScannedSource* scanned)
+{
+    glslang::TShader shader(EShLangFragment);
+    shader.setStrings(strings, 2);
+    shader.setPreamble(preamble);
+    shader.setScannedSource(scanned);
+    glslang::TShader::ForbidIncluder includer;
+    std::string output;
+    shader.preprocess(&glslang::DefaultTBuiltInResource, 100, ENoProfile, false, false, EShMsgDefault,
+                      &output, includer);
+    return output;
+}
+
+TEST_F(ScannedSourceTest, PermutationsMatchUnsharedCompiles)
+{
+    std::vector<std::string> expected;
+    std::vector<std::string> expectedText;
+    for (const char* preamble : permutations) {
+        expected.push_back(parseWithPreamble(permutedStrings, preamble, nullptr));
+        expectedText.push_back(preprocessWithPreamble(permutedStrings, preamble, nullptr));
+    }
+
+    // Each permutation compiles, to its own tree.
+    for (size_t p = 0; p < expected.size(); ++p) {
+        EXPECT_NE(expected[p].find("Function Definition: main("), std::string::npos) << expected[p];
+        EXPECT_EQ(expected[p].find("ERROR"), std::string::npos) << expected[p];
+        for (size_t q = 0; q < p; ++q) {
+            EXPECT_NE(expected[p], expected[q]);
+            EXPECT_NE(expectedText[p], expectedText[q]);
+        }
+    }
+
+    glslang::TScannedSource scanned;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t p = 0; p < expected.size(); ++p) {
+            EXPECT_EQ(parseWithPreamble(permutedStrings, permutations[p], &scanned), expected[p]);
+            EXPECT_EQ(preprocessWithPreamble(permutedStrings, permutations[p], &scanned), expectedText[p]);
+        }
+    }
+}
+
+TEST_F(ScannedSourceTest, ChangedStringsAreRecordedAgain)
+{
+    EXPECT_NE(parseWithPreamble(permutedStrings, permutations[3], nullptr),
+              parseWithPreamble(otherStrings, permutations[3], nullptr));
+
+    glslang::TScannedSource scanned;
+    for (int pass = 0; pass < 2; ++pass) {
+        EXPECT_EQ(parseWithPreamble(permutedStrings, permutations[3], &scanned),
+                  parseWithPreamble(permutedStrings, permutations[3], nullptr));
+        EXPECT_EQ(parseWithPreamble(otherStrings, permutations[3], &scanned),
+                  parseWithPreamble(otherStrings, permutations[3], nullptr));
+    }
+}
+
+TEST_F(ScannedSourceTest, ConcurrentCompilesMatchUnsharedCompiles)
+{
+    const int numPermutations = sizeof(permutations) / sizeof(permutations[0]);
+    std::vector<std::string> expected;
+    for (const char* preamble : permutations) {
+        expected.push_back(parseWithPreamble(permutedStrings, preamble, nullptr));
+        EXPECT_NE(expected.back().find("Function Definition: main("), std::string::npos) << expected.back();
+    }
+
+    // Threads start recording, replaying, or scanning for themselves while
+    // another records, depending on how they race.
+    glslang::TScannedSource scanned;
+    const int numThreads = 8;
+    std::vector<std::string> results(numThreads * 4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.push_back(std::thread([&, t]() {
+            for (int r = t; r < (int)results.size(); r += numThreads)
+                results[r] = parseWithPreamble(permutedStrings, permutations[r % numPermutations], &scanned);
+        }));
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    for (int r = 0; r < (int)results.size(); ++r)
+        EXPECT_EQ(results[r], expected[r % numPermutations]);
+}
+
+// A compile stopped by its memory limit, while recording into a TScannedSource,
+// leaves what it recorded usable by the next compile.
+TEST_F(ScannedSourceTest, RecordingStoppedByMemoryLimit)
+{
+    std::string contents = "#version 450\n";
+    for (int i = 0; i < 20000; ++i)
+        contents += "float f" + std::to_string(i) + " = " + std::to_string(i) + ".0;\n";
+    contents += "void main() { }\n";
+    const char* const strings[] = { contents.c_str() };
+
+    glslang::TScannedSource scanned;
+    const std::string limited = compileWithPreamble(strings, 1, "", &scanned, 1024 * 1024);
+    EXPECT_NE(limited.find("memory limit exceeded"), std::string::npos) << limited.substr(0, 1000);
+
+    const std::string unshared = compileWithPreamble(strings, 1, "", nullptr);
+    EXPECT_NE(unshared.find("f19999"), std::string::npos);
+    EXPECT_EQ(unshared.find("ERROR"), std::string::npos) << unshared.substr(0, 1000);
+    EXPECT_TRUE(compileWithPreamble(strings, 1, "", &scanned) == unshared);
+}
+
 // clang-format off
 INSTANTIATE_TEST_CASE_P(
     Glsl, PreprocessingTest,
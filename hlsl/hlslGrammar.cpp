@@ -607,19 +607,20 @@ bool HlslGrammar::acceptFullySpecifiedType(TType& type, TIntermNode*& nodeList)
         // whatever comes from acceptQualifier.
         assert(qualifier.layoutFormat == ElfNone);
 
-        qualifier.layoutFormat = type.getQualifier().layoutFormat;
-        qualifier.precision    = type.getQualifier().precision;
-
-        if (type.getQualifier().storage == EvqOut ||
-            type.getQualifier().storage == EvqBuffer) {
-            qualifier.storage      = type.getQualifier().storage;
-            qualifier.readonly     = type.getQualifier().readonly;
+        const TQualifier& typeQualifier = static_cast<const TType&>(type).getQualifier();
+        qualifier.layoutFormat = typeQualifier.layoutFormat;
+        qualifier.precision    = typeQualifier.precision;
+
+        if (typeQualifier.storage == EvqOut ||
+            typeQualifier.storage == EvqBuffer) {
+            qualifier.storage      = typeQualifier.storage;
+            qualifier.readonly     = typeQualifier.readonly;
         }
 
-        if (type.getQualifier().builtIn != EbvNone)
-            qualifier.builtIn = type.getQualifier().builtIn;
+        if (typeQualifier.builtIn != EbvNone)
+            qualifier.builtIn = typeQualifier.builtIn;
 
-        type.getQualifier()    = qualifier;
+        type.setQualifier(qualifier);
     }
 
     return true;
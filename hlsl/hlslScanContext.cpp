@@ -510,6 +510,7 @@ EHlslTokenClass HlslScanContext::tokenizeClass(HlslToken& token)
             return EHTokNone;
 
         tokenText = ppToken.name;
+        this->ppToken = &ppToken;
         loc = ppToken.loc;
         parserToken->loc = loc;
         switch (token) {
@@ -597,17 +598,40 @@ EHlslTokenClass HlslScanContext::tokenizeClass(HlslToken& token)
     } while (true);
 }
 
+// Get what's known about the identifier being tokenized, so it's looked up
+// in the keyword tables and allocated only the first time it's seen.
+const HlslScanContext::TIdentifier& HlslScanContext::getIdentifier()
+{
+    const int atom = ppToken->atom;
+    if (atom >= (int)identifiers.size())
+        identifiers.resize(atom + 1);
+
+    TIdentifier& identifier = identifiers[atom];
+    if (identifier.string == nullptr) {
+        identifier.string = NewPoolTString(tokenText);
+        if (ReservedSet->find(tokenText) != ReservedSet->end())
+            identifier.reserved = true;
+        else {
+            auto it = KeywordMap->find(tokenText);
+            if (it != KeywordMap->end())
+                identifier.keyword = it->second;
+        }
+    }
+
+    return identifier;
+}
+
 EHlslTokenClass HlslScanContext::tokenizeIdentifier()
 {
-    if (ReservedSet->find(tokenText) != ReservedSet->end())
+    const TIdentifier& identifier = getIdentifier();
+    if (identifier.reserved)
         return reservedWord();
 
-    auto it = KeywordMap->find(tokenText);
-    if (it == KeywordMap->end()) {
+    if (identifier.keyword == EHTokNone) {
         // Should have an identifier of some sort
         return identifierOrType();
     }
-    keyword = it->second;
+    keyword = identifier.keyword;
 
     switch (keyword) {
 
@@ -896,7 +920,7 @@ EHlslTokenClass HlslScanContext::tokenizeIdentifier()
 
 EHlslTokenClass HlslScanContext::identifierOrType()
 {
-    parserToken->string = NewPoolTString(tokenText);
+    parserToken->string = getIdentifier().string;
 
     return EHTokIdentifier;
 }
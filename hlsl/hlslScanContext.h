@@ -94,6 +94,16 @@ protected:
     EHlslTokenClass identifierOrReserved(bool reserved);
     EHlslTokenClass nonreservedKeyword(int version);
 
+    // What's known about an identifier, whatever the context.  Each
+    // identifier is learned on first sight, then found again by its atom.
+    struct TIdentifier {
+        TIdentifier() : string(nullptr), keyword(EHTokNone), reserved(false) { }
+        TString* string;          // shared by all tokens for the identifier
+        EHlslTokenClass keyword;  // EHTokNone if not a keyword
+        bool reserved;
+    };
+    const TIdentifier& getIdentifier();
+
     TParseContextBase& parseContext;
     TPpContext& ppContext;
     TSourceLoc loc;
@@ -102,6 +112,7 @@ protected:
 
     const char* tokenText;
     EHlslTokenClass keyword;
+    TVector<TIdentifier> identifiers;  // indexed by atom
 };
 
 } // end namespace glslang